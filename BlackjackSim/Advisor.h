@@ -0,0 +1,216 @@
+/*
+* @file Advisor.h
+* @brief In-process advisor that answers "what should I do here" from the cards the player has seen.
+*
+* This file defines the `Advisor` class. A query is the player's hand, the dealer's up card and
+* the count of unseen cards of each rank; the answer is the EV of every action and the best one.
+*
+* advise() is the fast path. When the advisor is built it works out, for every decision (hard
+* total, soft or not, first two cards or not, up card), the exact EV of each action off the top of
+* the shoe and how much each one moves when a single card of each rank is removed: the effects of
+* removal. A query scales the unseen cards up to a full shoe and adds up the effects of what is
+* missing, which is a table lookup and thirty multiply-adds. This is the linear estimate from
+* Griffin's "The Theory of Blackjack"; it is very good near the top of the shoe and drifts as the
+* shoe gets deep or lopsided.
+*
+* adviseExact() works the decision out exactly for the composition with
+* ExactCalculator::actionValues() and keeps the answer in a direct-mapped cache keyed on the whole
+* query, so asking about the same decision again, as the renderer does every frame, is a hash and
+* a compare. A miss costs anything from a fraction of a millisecond to tens of milliseconds.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using Advice = ExactCalculator::ActionValues;
+
+class Advisor
+{
+private:
+    static constexpr int CACHE_SIZE = 4096;     // Power of two
+    static constexpr int MAX_HARD = 21;
+
+    // One decision off the top of the shoe: the EV of each action and its effect of removal per rank
+    struct Entry
+    {
+        Advice top;
+        double hit[RANK_SLOTS];
+        double stand[RANK_SLOTS];
+        double doubleDown[RANK_SLOTS];
+    };
+    struct Slot
+    {
+        uint64_t key = ~0ull;
+        Advice advice;
+    };
+
+    Rules rules;
+    ExactCalculator calculator;
+    std::vector<Entry> table;       // Indexed by entryOf()
+    int full[RANK_SLOTS];
+    int fullLeft = 0;
+    std::vector<Slot> cache;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    // An Ace only makes a difference while it can still count as 11
+    static size_t entryOf(int hard, bool ace, bool first, int up)
+    {
+        bool soft = ace && hard <= 11;
+        return ((static_cast<size_t>(hard) * 2 + (soft ? 1 : 0)) * 2 + (first ? 1 : 0)) * RANK_SLOTS + up;
+    }
+
+    // The unseen counts and the decision packed into one word: the counts in mixed radix as
+    // ExactCalculator keys its shoes (up to 8 decks in under 53 bits), then the hand in 11 bits
+    static uint64_t keyOf(const int unseen[RANK_SLOTS], int hard, bool ace, int cards, int up)
+    {
+        uint64_t key = 0;
+        for (int r = 0; r < RANK_SLOTS; r++)
+            key = key * (r == 9 ? 129 : 33) + static_cast<uint64_t>(unseen[r]);
+        return (key << 11) | (static_cast<uint64_t>(hard) << 6) | (ace ? 32u : 0u) | (cards == 2 ? 16u : 0u)
+            | static_cast<uint64_t>(up);
+    }
+
+    static size_t slotOf(uint64_t key)
+    {
+        key ^= key >> 29;
+        key *= 0xBF58476D1CE4E5B9ull;
+        return static_cast<size_t>(key >> 52) & (CACHE_SIZE - 1);
+    }
+
+    // Exact values and effects of removal for every decision against one up card
+    void buildUpcard(int up)
+    {
+        int base[RANK_SLOTS];
+        std::copy(full, full + RANK_SLOTS, base);
+        base[up]--;
+        for (int hard = 2; hard <= MAX_HARD; hard++)
+        {
+            for (int soft = 0; soft < 2; soft++)
+            {
+                for (int first = 0; first < 2; first++)
+                {
+                    // Two cards make at most 20 hard
+                    if ((soft && hard > 11) || (first && hard > 20))
+                        continue;
+                    int cards = first ? 2 : 3;
+                    Entry& e = table[entryOf(hard, soft == 1, first == 1, up)];
+                    e.top = calculator.actionValues(base, hard, soft == 1, cards, up);
+                    for (int r = 0; r < RANK_SLOTS; r++)
+                    {
+                        e.hit[r] = e.stand[r] = e.doubleDown[r] = 0;
+                        if (base[r] == 0)
+                            continue;
+                        base[r]--;
+                        Advice less = calculator.actionValues(base, hard, soft == 1, cards, up);
+                        base[r]++;
+                        e.hit[r] = less.hit - e.top.hit;
+                        e.stand[r] = less.stand - e.top.stand;
+                        e.doubleDown[r] = less.doubleDown - e.top.doubleDown;
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    // Builds the tables for every decision, which takes a few seconds
+    explicit Advisor(const Rules& r)
+        : rules(r), calculator(r), table(entryOf(MAX_HARD + 1, false, false, 0)), cache(CACHE_SIZE)
+    {
+        int decks = std::max(1, std::min(rules.decks, MAX_SHOE_CARDS / 52));
+        for (int i = 0; i < RANK_SLOTS; i++)
+        {
+            full[i] = (i == 9 ? 16 : 4) * decks;
+            fullLeft += full[i];
+        }
+        for (int up = 0; up < RANK_SLOTS; up++)
+            buildUpcard(up);
+    }
+
+    /*******************************************************************************************
+    * Best action for a hand with hard total `hard` (Aces as 1) and `cards` cards against the up
+    * card `up` (rank slot, Ace = 0), given the unseen cards by rank slot, the hole card included.
+    * Estimated from the effects of removal; allocation free and constant time.
+    ********************************************************************************************/
+    Advice advise(const int unseen[RANK_SLOTS], int hard, bool ace, int cards, int up) const
+    {
+        hard = std::max(2, std::min(hard, MAX_HARD));
+        const Entry& e = table[entryOf(hard, ace, cards == 2 && hard <= 20, up)];
+        Advice v = e.top;
+        int left = 0;
+        for (int r = 0; r < RANK_SLOTS; r++)
+            left += unseen[r];
+        if (left > 0)
+        {
+            // How many of each rank are missing once the unseen cards are scaled back up to a full shoe
+            double scale = static_cast<double>(fullLeft - 1) / left;
+            for (int r = 0; r < RANK_SLOTS; r++)
+            {
+                double removed = full[r] - (r == up ? 1 : 0) - unseen[r] * scale;
+                v.hit += removed * e.hit[r];
+                v.stand += removed * e.stand[r];
+                v.doubleDown += removed * e.doubleDown[r];
+            }
+        }
+        v.canDouble = cards == 2 && rules.doubleAllowed;
+        v.canSurrender = cards == 2 && rules.surrenderAllowed;
+        v.chooseBest(hard);
+        return v;
+    }
+
+    /*******************************************************************************************
+    * Same question answered exactly for this composition, through the cache. Not thread safe.
+    ********************************************************************************************/
+    const Advice& adviseExact(const int unseen[RANK_SLOTS], int hard, bool ace, int cards, int up)
+    {
+        uint64_t key = keyOf(unseen, hard, ace, cards, up);
+        Slot& slot = cache[slotOf(key)];
+        if (slot.key == key)
+        {
+            hits++;
+            return slot.advice;
+        }
+        misses++;
+        slot.key = key;
+        slot.advice = calculator.actionValues(unseen, hard, ace, cards, up);
+        return slot.advice;
+    }
+
+    // The decision in a snapshot, which is only meaningful during the player's turn
+    static void decisionOf(const TableSnapshot& s, int& hard, bool& ace, int& up)
+    {
+        hard = 0;
+        ace = false;
+        for (int i = 0; i < s.playerCount; i++)
+        {
+            hard += s.playerCards[i].getValue();
+            ace = ace || s.playerCards[i].getRank() == Rank::Ace;
+        }
+        up = rankSlot(s.dealerCards[0]);
+    }
+
+    Advice advise(const TableSnapshot& s) const
+    {
+        int hard, up;
+        bool ace;
+        decisionOf(s, hard, ace, up);
+        return advise(s.unseen, hard, ace, s.playerCount, up);
+    }
+
+    const Advice& adviseExact(const TableSnapshot& s)
+    {
+        int hard, up;
+        bool ace;
+        decisionOf(s, hard, ace, up);
+        return adviseExact(s.unseen, hard, ace, s.playerCount, up);
+    }
+
+    uint64_t getHits() const { return hits; }
+    uint64_t getMisses() const { return misses; }
+};
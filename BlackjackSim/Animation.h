@@ -0,0 +1,221 @@
+/*
+* @file Animation.h
+* @brief Animation scheduler for dealt cards, the hole-card flip and chip movement.
+*
+* This file defines the `Animator` class. Game code queues animation events (deal a card to a
+* hand, flip the dealer's hole card, move a chip) and returns immediately; the animator plays them
+* back one after another on a fixed-timestep clock. Rendering interpolates between the last two
+* update steps, so motion stays smooth no matter how the frame rate lines up with the timestep.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <vector>
+#include <algorithm>
+
+enum class HandOwner
+{
+    Player, Dealer
+};
+
+enum class AnimationType
+{
+    DealCard, FlipCard, MoveChip
+};
+
+struct Animation
+{
+    AnimationType type = AnimationType::DealCard;
+    HandOwner owner = HandOwner::Player;
+    GLuint texture = 0;     // Card face or chip texture
+    GLuint backTexture = 0; // Card back, only used by FlipCard
+    float fromX = 0, fromY = 0;
+    float toX = 0, toY = 0;
+    int width = 0, height = 0;
+    double startTime = 0;   // Clock time the animation begins
+    double duration = 0;
+    double progress = 0;    // 0..1 at the current update step
+    double prevProgress = 0; // 0..1 at the previous update step
+};
+
+class Animator
+{
+public:
+    static constexpr double STEP = 1.0 / 120.0;        // Fixed update timestep in seconds
+    static constexpr double MAX_FRAME_TIME = 0.25;     // Clamp long stalls so we don't spiral
+
+private:
+    std::vector<Animation> active;
+    double clock = 0;        // Time advanced in fixed steps
+    double accumulator = 0;  // Real time not yet consumed by a step
+    double nextStart = 0;    // Events are sequenced, each one starts after the previous
+    int landedPlayer = 0;    // Cards that finished their deal animation
+    int landedDealer = 0;
+    bool holeCardShown = false;
+
+    static double smoothStep(double t) { return t * t * (3.0 - 2.0 * t); }
+
+    void push(Animation a, double gap)
+    {
+        a.startTime = std::max(clock, nextStart);
+        nextStart = a.startTime + gap;
+        active.push_back(a);
+    }
+
+    void finish(const Animation& a)
+    {
+        if (a.type == AnimationType::DealCard)
+        {
+            if (a.owner == HandOwner::Player)
+                landedPlayer++;
+            else
+                landedDealer++;
+        }
+        else if (a.type == AnimationType::FlipCard)
+        {
+            holeCardShown = true;
+        }
+    }
+
+    // Advance every animation by one fixed step
+    void tick()
+    {
+        clock += STEP;
+        for (Animation& a : active)
+        {
+            a.prevProgress = a.progress;
+            a.progress = std::min(1.0, std::max(0.0, (clock - a.startTime) / a.duration));
+        }
+        // Finished animations stay one extra step so the interpolated frame reaches the end point
+        for (const Animation& a : active)
+        {
+            if (a.prevProgress >= 1.0)
+                finish(a);
+        }
+        active.erase(std::remove_if(active.begin(), active.end(),
+            [](const Animation& a) { return a.prevProgress >= 1.0; }), active.end());
+    }
+
+public:
+    int getLanded(HandOwner owner) const { return owner == HandOwner::Player ? landedPlayer : landedDealer; }
+    bool getHoleCardShown() const { return holeCardShown; }
+    bool isIdle() const { return active.empty(); }
+
+    bool getFlipping() const
+    {
+        for (const Animation& a : active)
+        {
+            if (a.type == AnimationType::FlipCard && a.progress > 0.0)
+                return true;
+        }
+        return false;
+    }
+
+    // Start a new round: nothing has been dealt and the hole card is face down
+    void resetHands()
+    {
+        landedPlayer = 0;
+        landedDealer = 0;
+        holeCardShown = false;
+        nextStart = clock;
+        active.erase(std::remove_if(active.begin(), active.end(),
+            [](const Animation& a) { return a.type != AnimationType::MoveChip; }), active.end());
+    }
+
+    // Queue a card flying from the shoe to (toX, toY)
+    void dealCard(HandOwner owner, GLuint texture, int width, int height, float toX, float toY)
+    {
+        Animation a;
+        a.type = AnimationType::DealCard;
+        a.owner = owner;
+        a.texture = texture;
+        a.fromX = 680;
+        a.fromY = 560;
+        a.toX = toX;
+        a.toY = toY;
+        a.width = width;
+        a.height = height;
+        a.duration = 0.3;
+        push(a, 0.2);
+    }
+
+    // Queue the dealer's hole card turning over in place
+    void flipCard(GLuint face, GLuint back, int width, int height, float x, float y)
+    {
+        Animation a;
+        a.type = AnimationType::FlipCard;
+        a.owner = HandOwner::Dealer;
+        a.texture = face;
+        a.backTexture = back;
+        a.fromX = a.toX = x;
+        a.fromY = a.toY = y;
+        a.width = width;
+        a.height = height;
+        a.duration = 0.3;
+        push(a, 0.35);
+    }
+
+    // Chips don't wait for the card queue, they start right away
+    void moveChip(GLuint texture, int width, int height, float fromX, float fromY, float toX, float toY)
+    {
+        Animation a;
+        a.type = AnimationType::MoveChip;
+        a.texture = texture;
+        a.fromX = fromX;
+        a.fromY = fromY;
+        a.toX = toX;
+        a.toY = toY;
+        a.width = width;
+        a.height = height;
+        a.duration = 0.25;
+        a.startTime = clock;
+        active.push_back(a);
+    }
+
+    // Consume real elapsed time in fixed steps
+    void update(double frameTime)
+    {
+        accumulator += std::min(frameTime, MAX_FRAME_TIME);
+        while (accumulator >= STEP)
+        {
+            tick();
+            accumulator -= STEP;
+        }
+    }
+
+    // Draw everything in flight, interpolated between the last two steps
+    void draw() const
+    {
+        double alpha = accumulator / STEP;
+        glEnable(GL_TEXTURE_2D);
+        glColor3f(1.0f, 1.0f, 1.0f);
+        for (const Animation& a : active)
+        {
+            if (a.progress <= 0.0)
+                continue;
+            double t = smoothStep(a.prevProgress + (a.progress - a.prevProgress) * alpha);
+            float x = static_cast<float>(a.fromX + (a.toX - a.fromX) * t);
+            float y = static_cast<float>(a.fromY + (a.toY - a.fromY) * t);
+            float w = static_cast<float>(a.width);
+            GLuint tex = a.texture;
+            if (a.type == AnimationType::FlipCard)
+            {
+                // First half: the back narrows to nothing. Second half: the face widens back out.
+                double half = t < 0.5 ? 1.0 - t * 2.0 : t * 2.0 - 1.0;
+                tex = t < 0.5 ? a.backTexture : a.texture;
+                x += static_cast<float>(w * (1.0 - half) / 2.0);
+                w = static_cast<float>(w * half);
+            }
+            glBindTexture(GL_TEXTURE_2D, tex);
+            glBegin(GL_QUADS);
+            glTexCoord2i(0, 1); glVertex2f(x, y);                         // top-left
+            glTexCoord2i(1, 1); glVertex2f(x + w, y);                     // top-right
+            glTexCoord2i(1, 0); glVertex2f(x + w, y - a.height);          // bottom-right
+            glTexCoord2i(0, 0); glVertex2f(x, y - a.height);              // bottom-left
+            glEnd();
+        }
+        glDisable(GL_TEXTURE_2D);
+    }
+};
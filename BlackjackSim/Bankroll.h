@@ -0,0 +1,246 @@
+/*
+* @file Bankroll.h
+* @brief Risk of ruin and bankroll trajectories over many independent sessions.
+*
+* This file defines `P2Quantile`, a streaming quantile estimator (the P-squared algorithm of
+* Jain and Chlamtac) that follows one quantile with five markers, and `BankrollSimulator`,
+* which plays sessions with a real bankroll until it is ruined, hits the stop-loss or the win
+* goal, or runs out of rounds. Each checkpoint along the way feeds one estimator per percentile
+* band, so memory stays the same however many sessions are played.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+class P2Quantile
+{
+private:
+    double p;
+    double heights[5];      // Marker heights, the middle one is the estimate
+    double positions[5];    // Actual marker positions (1-based)
+    double desired[5];      // Desired marker positions
+    double increments[5];
+    uint64_t count = 0;
+
+    // Piecewise-parabolic prediction for moving marker i by d
+    double parabolic(int i, double d) const
+    {
+        double n0 = positions[i - 1], n1 = positions[i], n2 = positions[i + 1];
+        return heights[i] + d / (n2 - n0)
+            * ((n1 - n0 + d) * (heights[i + 1] - heights[i]) / (n2 - n1)
+                + (n2 - n1 - d) * (heights[i] - heights[i - 1]) / (n1 - n0));
+    }
+
+    double linear(int i, int d) const
+    {
+        return heights[i] + d * (heights[i + d] - heights[i]) / (positions[i + d] - positions[i]);
+    }
+
+public:
+    explicit P2Quantile(double quantile = 0.5)
+        : p(quantile)
+    {
+    }
+
+    uint64_t getCount() const { return count; }
+
+    void add(double x)
+    {
+        if (count < 5)
+        {
+            heights[count++] = x;
+            if (count == 5)
+            {
+                std::sort(heights, heights + 5);
+                for (int i = 0; i < 5; i++)
+                    positions[i] = i + 1;
+                desired[0] = 1; desired[1] = 1 + 2 * p; desired[2] = 1 + 4 * p; desired[3] = 3 + 2 * p; desired[4] = 5;
+                increments[0] = 0; increments[1] = p / 2; increments[2] = p; increments[3] = (1 + p) / 2; increments[4] = 1;
+            }
+            return;
+        }
+        count++;
+
+        // Find the cell x falls in, stretching the end markers if needed
+        int k;
+        if (x < heights[0])
+        {
+            heights[0] = x;
+            k = 0;
+        }
+        else if (x >= heights[4])
+        {
+            heights[4] = x;
+            k = 3;
+        }
+        else
+        {
+            k = 0;
+            while (x >= heights[k + 1])
+                k++;
+        }
+        for (int i = k + 1; i < 5; i++)
+            positions[i]++;
+        for (int i = 0; i < 5; i++)
+            desired[i] += increments[i];
+
+        // Nudge the middle markers towards where they should be
+        for (int i = 1; i < 4; i++)
+        {
+            double d = desired[i] - positions[i];
+            if ((d >= 1 && positions[i + 1] - positions[i] > 1) || (d <= -1 && positions[i - 1] - positions[i] < -1))
+            {
+                int step = d > 0 ? 1 : -1;
+                double h = parabolic(i, step);
+                heights[i] = (heights[i - 1] < h && h < heights[i + 1]) ? h : linear(i, step);
+                positions[i] += step;
+            }
+        }
+    }
+
+    double value() const
+    {
+        if (count >= 5)
+            return heights[2];
+        if (count == 0)
+            return 0.0;
+        // Too few samples for the markers, use the exact quantile
+        double sorted[5];
+        std::copy(heights, heights + count, sorted);
+        std::sort(sorted, sorted + count);
+        return sorted[std::min<uint64_t>(count - 1, static_cast<uint64_t>(p * count))];
+    }
+};
+
+struct BankrollSettings
+{
+    uint64_t sessions = 10000;
+    float bankroll = 50;
+    float unit = 1;                 // One betting unit; the session is ruined once it can't be bet
+    float stopLoss = 0;             // Quit after losing this much, 0 plays until ruin
+    float winGoal = 0;              // Quit after winning this much, 0 means no goal
+    uint64_t maxRounds = 1000;
+    uint64_t checkpointRounds = 100;
+};
+
+class BankrollSimulator
+{
+private:
+    static const int BANDS = 5;
+    BankrollSettings settings;
+    const double bands[BANDS] = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+
+    uint64_t ruined = 0;
+    uint64_t stoppedLoss = 0;
+    uint64_t reachedGoal = 0;
+    double ruinRoundsTotal = 0;
+    std::vector<P2Quantile> ruinRounds;         // One per band
+    std::vector<P2Quantile> trajectory;         // BANDS per checkpoint
+    std::vector<P2Quantile> finalBankroll;      // One per band
+
+    static void addAll(P2Quantile* q, double x)
+    {
+        for (int b = 0; b < BANDS; b++)
+            q[b].add(x);
+    }
+
+    static void printBands(const char* label, const P2Quantile* q)
+    {
+        std::printf("%-12s", label);
+        for (int b = 0; b < BANDS; b++)
+            std::printf(" %10.2f", q[b].value());
+        std::printf("\n");
+    }
+
+public:
+    explicit BankrollSimulator(const BankrollSettings& s)
+        : settings(s)
+    {
+        size_t checkpoints = settings.checkpointRounds > 0 ? settings.maxRounds / settings.checkpointRounds : 0;
+        for (int b = 0; b < BANDS; b++)
+        {
+            ruinRounds.emplace_back(bands[b]);
+            finalBankroll.emplace_back(bands[b]);
+        }
+        for (size_t c = 0; c < checkpoints; c++)
+        {
+            for (int b = 0; b < BANDS; b++)
+                trajectory.emplace_back(bands[b]);
+        }
+    }
+
+    // Play every session; `strategy` may be nullptr for flat bets and basic strategy
+    void run(Simulator& sim, const CountStrategy* strategy = nullptr)
+    {
+        sim.setStrategy(strategy);
+        sim.setUnit(settings.unit);
+        SimResult stats;
+        const Player& player = sim.getPlayer();
+        for (uint64_t session = 0; session < settings.sessions; session++)
+        {
+            sim.setBankroll(settings.bankroll);
+            size_t checkpoint = 0;
+            for (uint64_t round = 0; ; round++)
+            {
+                float bal = player.getBal();
+                if (bal < settings.unit || sim.getTable().getGameOver())
+                {
+                    ruined++;
+                    ruinRoundsTotal += round;
+                    addAll(ruinRounds.data(), static_cast<double>(round));
+                    break;
+                }
+                if (settings.stopLoss > 0 && bal <= settings.bankroll - settings.stopLoss)
+                {
+                    stoppedLoss++;
+                    break;
+                }
+                if (settings.winGoal > 0 && bal >= settings.bankroll + settings.winGoal)
+                {
+                    reachedGoal++;
+                    break;
+                }
+                if (round == settings.maxRounds)
+                    break;
+                sim.playRound(stats);
+                if (settings.checkpointRounds > 0 && (round + 1) % settings.checkpointRounds == 0 && checkpoint * BANDS < trajectory.size())
+                    addAll(&trajectory[BANDS * checkpoint++], player.getBal());
+            }
+            // A session that stopped early stays where it stopped for the rest of the checkpoints
+            for (; checkpoint * BANDS < trajectory.size(); checkpoint++)
+                addAll(&trajectory[BANDS * checkpoint], player.getBal());
+            addAll(finalBankroll.data(), player.getBal());
+        }
+    }
+
+    double getRiskOfRuin() const { return settings.sessions > 0 ? static_cast<double>(ruined) / settings.sessions : 0.0; }
+
+    void print() const
+    {
+        double sessions = static_cast<double>(std::max<uint64_t>(settings.sessions, 1));
+        std::printf("Sessions: %llu  Bankroll: %.2f  Unit: %.2f\n", static_cast<unsigned long long>(settings.sessions),
+            settings.bankroll, settings.unit);
+        std::printf("Risk of ruin: %.2f%%  Stop-loss: %.2f%%  Win goal: %.2f%%\n", ruined * 100.0 / sessions,
+            stoppedLoss * 100.0 / sessions, reachedGoal * 100.0 / sessions);
+        if (ruined > 0)
+        {
+            std::printf("Rounds to ruin: mean %.1f\n", ruinRoundsTotal / ruined);
+            printBands("  p5..p95", ruinRounds.data());
+        }
+        std::printf("%-12s %10s %10s %10s %10s %10s\n", "Bankroll", "p5", "p25", "p50", "p75", "p95");
+        char label[32];
+        for (size_t c = 0; c * BANDS < trajectory.size(); c++)
+        {
+            std::snprintf(label, sizeof(label), "round %llu", static_cast<unsigned long long>((c + 1) * settings.checkpointRounds));
+            printBands(label, &trajectory[BANDS * c]);
+        }
+        printBands("final", finalBankroll.data());
+    }
+};
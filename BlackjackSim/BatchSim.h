@@ -0,0 +1,333 @@
+/*
+* @file BatchSim.h
+* @brief Lockstep batch engine that plays many independent rounds per SIMD register.
+*
+* This file defines the `BatchSimulator` class. Every lane of a vector register is a separate
+* table with its own single-deck shoe. All lanes deal, decide and draw together: totals, soft
+* flags and card counts stay in registers, basic strategy is a gathered table lookup, and lanes
+* whose hand is finished are masked off instead of branched around. The rules are the same as
+* `Table` (dealer stands on 17 or hits soft 17, peeks or not, surrender and double on the first
+* two cards, insurance always declined as basic strategy does), so results can be checked against
+* `Simulator`.
+*
+* AVX-512 builds run 16 lanes per register, AVX2 builds run 8, and anything else falls back to
+* plain loops over 8 lanes. The `Groups` template parameter runs several registers per step,
+* e.g. BatchSimulator<4> plays 32 rounds at once on AVX2.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <cstdint>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace simd
+{
+#if defined(__AVX512F__)
+    const int WIDTH = 16;
+    typedef __m512i VecI;
+    typedef __mmask16 Mask;
+
+    inline VecI set1(int32_t x) { return _mm512_set1_epi32(x); }
+    inline VecI load(const int32_t* p) { return _mm512_load_si512(p); }
+    inline void store(int32_t* p, VecI v) { _mm512_store_si512(p, v); }
+    inline VecI add(VecI a, VecI b) { return _mm512_add_epi32(a, b); }
+    inline VecI shl(VecI a, int n) { return _mm512_slli_epi32(a, n); }
+    inline Mask eq(VecI a, VecI b) { return _mm512_cmpeq_epi32_mask(a, b); }
+    inline Mask gt(VecI a, VecI b) { return _mm512_cmpgt_epi32_mask(a, b); }
+    inline Mask maskAnd(Mask a, Mask b) { return a & b; }
+    inline Mask maskOr(Mask a, Mask b) { return a | b; }
+    inline Mask maskAndNot(Mask a, Mask b) { return a & ~b; }
+    inline Mask allLanes() { return 0xFFFF; }
+    inline Mask noLanes() { return 0; }
+    inline bool any(Mask m) { return m != 0; }
+    // m ? a : b
+    inline VecI select(Mask m, VecI a, VecI b) { return _mm512_mask_blend_epi32(m, b, a); }
+    inline VecI gather(const int32_t* base, VecI index) { return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, index, base, 4); }
+    inline VecI laneIds(int first)
+    {
+        return _mm512_add_epi32(_mm512_set1_epi32(first), _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+    }
+#elif defined(__AVX2__)
+    const int WIDTH = 8;
+    typedef __m256i VecI;
+    typedef __m256i Mask;
+
+    inline VecI set1(int32_t x) { return _mm256_set1_epi32(x); }
+    inline VecI load(const int32_t* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+    inline void store(int32_t* p, VecI v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+    inline VecI add(VecI a, VecI b) { return _mm256_add_epi32(a, b); }
+    inline VecI shl(VecI a, int n) { return _mm256_slli_epi32(a, n); }
+    inline Mask eq(VecI a, VecI b) { return _mm256_cmpeq_epi32(a, b); }
+    inline Mask gt(VecI a, VecI b) { return _mm256_cmpgt_epi32(a, b); }
+    inline Mask maskAnd(Mask a, Mask b) { return _mm256_and_si256(a, b); }
+    inline Mask maskOr(Mask a, Mask b) { return _mm256_or_si256(a, b); }
+    inline Mask maskAndNot(Mask a, Mask b) { return _mm256_andnot_si256(b, a); }
+    inline Mask allLanes() { return _mm256_set1_epi32(-1); }
+    inline Mask noLanes() { return _mm256_setzero_si256(); }
+    inline bool any(Mask m) { return _mm256_movemask_epi8(m) != 0; }
+    // m ? a : b
+    inline VecI select(Mask m, VecI a, VecI b) { return _mm256_blendv_epi8(b, a, m); }
+    inline VecI gather(const int32_t* base, VecI index) { return _mm256_i32gather_epi32(base, index, 4); }
+    inline VecI laneIds(int first) { return _mm256_add_epi32(_mm256_set1_epi32(first), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+#else
+    // Scalar fallback: the same operations as plain loops, which compilers can still auto-vectorize
+    const int WIDTH = 8;
+    struct VecI { int32_t v[WIDTH]; };
+    typedef VecI Mask;
+
+    inline VecI set1(int32_t x) { VecI r; for (int i = 0; i < WIDTH; i++) r.v[i] = x; return r; }
+    inline VecI load(const int32_t* p) { VecI r; for (int i = 0; i < WIDTH; i++) r.v[i] = p[i]; return r; }
+    inline void store(int32_t* p, VecI a) { for (int i = 0; i < WIDTH; i++) p[i] = a.v[i]; }
+    inline VecI add(VecI a, VecI b) { for (int i = 0; i < WIDTH; i++) a.v[i] += b.v[i]; return a; }
+    inline VecI shl(VecI a, int n) { for (int i = 0; i < WIDTH; i++) a.v[i] <<= n; return a; }
+    inline Mask eq(VecI a, VecI b) { for (int i = 0; i < WIDTH; i++) a.v[i] = a.v[i] == b.v[i] ? -1 : 0; return a; }
+    inline Mask gt(VecI a, VecI b) { for (int i = 0; i < WIDTH; i++) a.v[i] = a.v[i] > b.v[i] ? -1 : 0; return a; }
+    inline Mask maskAnd(Mask a, Mask b) { for (int i = 0; i < WIDTH; i++) a.v[i] &= b.v[i]; return a; }
+    inline Mask maskOr(Mask a, Mask b) { for (int i = 0; i < WIDTH; i++) a.v[i] |= b.v[i]; return a; }
+    inline Mask maskAndNot(Mask a, Mask b) { for (int i = 0; i < WIDTH; i++) a.v[i] &= ~b.v[i]; return a; }
+    inline Mask allLanes() { return set1(-1); }
+    inline Mask noLanes() { return set1(0); }
+    inline bool any(Mask m) { int32_t r = 0; for (int i = 0; i < WIDTH; i++) r |= m.v[i]; return r != 0; }
+    // m ? a : b
+    inline VecI select(Mask m, VecI a, VecI b) { for (int i = 0; i < WIDTH; i++) b.v[i] = m.v[i] ? a.v[i] : b.v[i]; return b; }
+    inline VecI gather(const int32_t* base, VecI index) { for (int i = 0; i < WIDTH; i++) index.v[i] = base[index.v[i]]; return index; }
+    inline VecI laneIds(int first) { VecI r; for (int i = 0; i < WIDTH; i++) r.v[i] = first + i; return r; }
+#endif
+
+    inline Mask le(VecI a, VecI b) { return maskAndNot(allLanes(), gt(a, b)); }
+}
+
+// Smallest shift with (1 << SHIFT) >= n
+constexpr int shiftFor(int n)
+{
+    return n <= 1 ? 0 : 1 + shiftFor((n + 1) / 2);
+}
+
+template <int Groups>
+class BatchSimulator
+{
+public:
+    static const int LANES = simd::WIDTH * Groups;
+    static const int DECK_CARDS = 52;
+    static const int CUT_CARDS = 26;    // Reshuffle at 50%, same as Table::deal
+
+private:
+    // Strategy lookup: [first decision][soft][total 0..31][up card 0..15]
+    static const int TABLE_SIZE = 2 * 2 * 32 * 16;
+    static const int SHIFT = shiftFor(LANES);
+
+    alignas(64) int32_t shoe[DECK_CARDS << SHIFT]; // Card i of lane l lives at shoe[(i << SHIFT) + l]
+    alignas(64) int32_t cursor[LANES];
+    alignas(64) int32_t wins[LANES];
+    alignas(64) int32_t losses[LANES];
+    alignas(64) int32_t pushes[LANES];
+    alignas(64) int32_t blackjacks[LANES];
+    alignas(64) int32_t surrenders[LANES];
+    alignas(64) int32_t netHalves[LANES];       // Net result in half units, so 3:2 stays exact
+    alignas(64) int32_t actions[TABLE_SIZE];
+    Xoshiro256 rng[LANES];
+    uint64_t roundsSinceFlush = 0;
+    bool hitSoft17;
+    bool peeks;
+
+    void shuffleLane(int lane)
+    {
+        for (int i = DECK_CARDS; i > 1; i--)
+        {
+            int j = static_cast<int>(rng[lane].below(i));
+            std::swap(shoe[((i - 1) << SHIFT) + lane], shoe[(j << SHIFT) + lane]);
+        }
+        cursor[lane] = 0;
+    }
+
+    // Move the per-lane counters into the result before any of them can overflow
+    void flush(SimResult& stats)
+    {
+        for (int l = 0; l < LANES; l++)
+        {
+            stats.wins += wins[l];
+            stats.losses += losses[l];
+            stats.pushes += pushes[l];
+            stats.blackjacks += blackjacks[l];
+            stats.surrenders += surrenders[l];
+            stats.net += netHalves[l] * 0.5;
+            wins[l] = losses[l] = pushes[l] = blackjacks[l] = surrenders[l] = netHalves[l] = 0;
+        }
+        roundsSinceFlush = 0;
+    }
+
+    void playGroup(int group)
+    {
+        using namespace simd;
+        const int base = group * WIDTH;
+        const VecI lane = laneIds(base);
+        const VecI one = set1(1), two = set1(2), ten = set1(10), sixteen = set1(16), twentyOne = set1(21);
+        VecI cur = load(cursor + base);
+
+        // Deal one card to every lane in `m`, finished lanes keep their cursor
+        auto draw = [&](Mask m) {
+            VecI card = gather(shoe, add(shl(cur, SHIFT), lane));
+            cur = select(m, add(cur, one), cur);
+            return card;
+        };
+        auto softTotal = [&](VecI hard, Mask ace) {
+            Mask soft = maskAnd(ace, le(add(hard, ten), twentyOne));
+            return select(soft, add(hard, ten), hard);
+        };
+
+        Mask all = allLanes();
+        VecI p1 = draw(all), d1 = draw(all), p2 = draw(all), d2 = draw(all);
+        VecI pHard = add(p1, p2), dHard = add(d1, d2);
+        Mask pAce = maskOr(eq(p1, one), eq(p2, one));
+        Mask dAce = maskOr(eq(d1, one), eq(d2, one));
+        VecI pCards = two, dCards = two, betUnits = one;
+        Mask active = all, surrendered = noLanes(), playerBust = noLanes();
+        VecI upColumn = d1;  // Up card 1..10 is the table column
+        int firstDecision = 1;
+
+        // A natural the table knows about settles the lane before the player's turn
+        Mask playerBJ = maskAnd(pAce, eq(pHard, set1(11)));
+        Mask dealerBJ = maskAnd(dAce, eq(dHard, set1(11)));
+        Mask settled = peeks ? maskOr(playerBJ, dealerBJ) : playerBJ;
+        active = maskAndNot(active, settled);
+
+        // Player's turn: look up every live lane's play, draw for the ones that hit or double
+        while (any(active))
+        {
+            Mask soft = maskAnd(pAce, le(add(pHard, ten), twentyOne));
+            VecI total = select(soft, add(pHard, ten), pHard);
+            VecI row = add(set1(firstDecision * 64), select(soft, set1(32), set1(0)));
+            VecI index = add(shl(add(row, total), 4), upColumn);
+            VecI act = gather(actions, index);
+
+            Mask hit = maskAnd(active, eq(act, set1(static_cast<int>(Action::Hit))));
+            Mask dbl = maskAnd(active, eq(act, set1(static_cast<int>(Action::DoubleDown))));
+            Mask sur = maskAnd(active, eq(act, set1(static_cast<int>(Action::Surrender))));
+            Mask stand = maskAnd(active, eq(act, set1(static_cast<int>(Action::Stand))));
+            surrendered = maskOr(surrendered, sur);
+            betUnits = select(dbl, two, betUnits);
+
+            Mask draws = maskOr(hit, dbl);
+            VecI card = draw(draws);
+            pHard = select(draws, add(pHard, card), pHard);
+            pCards = select(draws, add(pCards, one), pCards);
+            pAce = maskOr(pAce, maskAnd(draws, eq(card, one)));
+            Mask bust = maskAnd(draws, gt(pHard, twentyOne));
+            playerBust = maskOr(playerBust, bust);
+            active = maskAndNot(active, maskOr(maskOr(stand, sur), maskOr(dbl, bust)));
+            firstDecision = 0;
+        }
+
+        // Dealer's turn: draws to 17, and on a soft 17 too under H17, like Dealer::takeTurn
+        auto dealerDraws = [&](Mask live) {
+            Mask soft = maskAnd(dAce, le(add(dHard, ten), twentyOne));
+            VecI total = select(soft, add(dHard, ten), dHard);
+            Mask draws = le(total, sixteen);
+            if (hitSoft17)
+                draws = maskOr(draws, maskAnd(soft, eq(total, set1(17))));
+            return maskAnd(live, draws);
+        };
+        Mask dealing = maskAndNot(maskAndNot(all, settled), maskOr(playerBust, surrendered));
+        Mask drawing = dealerDraws(dealing);
+        while (any(drawing))
+        {
+            VecI card = draw(drawing);
+            dHard = select(drawing, add(dHard, card), dHard);
+            dCards = select(drawing, add(dCards, one), dCards);
+            dAce = maskOr(dAce, maskAnd(drawing, eq(card, one)));
+            drawing = dealerDraws(drawing);
+        }
+
+        // Settle, same order of checks as Table::settle
+        VecI pTotal = softTotal(pHard, pAce), dTotal = softTotal(dHard, dAce);
+        Mask dealerBust = gt(dHard, twentyOne);
+        VecI stake = add(betUnits, betUnits);
+        VecI negStake = select(eq(betUnits, two), set1(-4), set1(-2));
+
+        Mask win = maskOr(dealerBust, gt(pTotal, dTotal));
+        Mask loss = maskAndNot(gt(dTotal, pTotal), win);
+        VecI net = select(win, stake, select(loss, negStake, set1(0)));
+        Mask isWin = win, isLoss = loss;
+        Mask bjOnly = maskAndNot(playerBJ, dealerBJ);
+        Mask dealerOnly = maskAndNot(dealerBJ, playerBJ);
+        net = select(dealerOnly, negStake, net);
+        isWin = maskAndNot(isWin, dealerOnly);
+        isLoss = maskOr(isLoss, dealerOnly);
+        net = select(bjOnly, set1(3), net);
+        isWin = maskOr(isWin, bjOnly);
+        isLoss = maskAndNot(isLoss, bjOnly);
+        net = select(playerBust, negStake, net);
+        isWin = maskAndNot(isWin, playerBust);
+        isLoss = maskOr(isLoss, playerBust);
+        net = select(surrendered, set1(-1), net);
+        isWin = maskAndNot(isWin, surrendered);
+        isLoss = maskOr(isLoss, surrendered);
+        Mask isPush = maskAndNot(maskAndNot(all, isWin), isLoss);
+        Mask isBJ = maskAndNot(maskAndNot(bjOnly, playerBust), surrendered);
+
+        store(cursor + base, cur);
+        store(netHalves + base, add(load(netHalves + base), net));
+        store(wins + base, add(load(wins + base), select(isWin, one, set1(0))));
+        store(losses + base, add(load(losses + base), select(isLoss, one, set1(0))));
+        store(pushes + base, add(load(pushes + base), select(isPush, one, set1(0))));
+        store(blackjacks + base, add(load(blackjacks + base), select(isBJ, one, set1(0))));
+        store(surrenders + base, add(load(surrenders + base), select(surrendered, one, set1(0))));
+    }
+
+public:
+    // Every lane gets its own shoe seeded from `seed`; only the dealer's rules are taken from `rules`
+    explicit BatchSimulator(uint64_t seed, const Rules& rules = Rules())
+        : hitSoft17(rules.dealerHitsSoft17), peeks(rules.dealerPeeks)
+    {
+        for (int l = 0; l < LANES; l++)
+        {
+            int i = 0;
+            for (int rank = 0; rank < 13; ++rank)
+                for (int suit = 0; suit < 4; ++suit)
+                    shoe[(i++ << SHIFT) + l] = rank >= 9 ? 10 : rank + 1;
+            rng[l].seed(seed + l);
+            shuffleLane(l);
+            wins[l] = losses[l] = pushes[l] = blackjacks[l] = surrenders[l] = netHalves[l] = 0;
+        }
+
+        // Bake basic strategy into the lookup table; the first decision may double or surrender
+        for (int first = 0; first < 2; first++)
+            for (int soft = 0; soft < 2; soft++)
+                for (int total = 0; total < 32; total++)
+                    for (int up = 0; up < 16; up++)
+                    {
+                        Action a = Action::Stand;
+                        if (up >= 1 && up <= 10 && total >= 2 && total <= 21)
+                            a = basicStrategy(total, soft != 0, up, first != 0, first != 0);
+                        actions[((first * 2 + soft) * 32 + total) * 16 + up] = static_cast<int32_t>(a);
+                    }
+    }
+
+    // Play at least `rounds` rounds (rounded up to a whole number of batches)
+    SimResult run(uint64_t rounds)
+    {
+        SimResult stats;
+        uint64_t batches = (rounds + LANES - 1) / LANES;
+        for (uint64_t b = 0; b < batches; b++)
+        {
+            for (int l = 0; l < LANES; l++)
+            {
+                if (DECK_CARDS - cursor[l] <= CUT_CARDS)
+                    shuffleLane(l);
+            }
+            for (int g = 0; g < Groups; g++)
+                playGroup(g);
+            // A lane moves at most 4 half units a round, so this keeps the int32 counters safe
+            if (++roundsSinceFlush == (1u << 24))
+                flush(stats);
+        }
+        flush(stats);
+        stats.rounds = batches * LANES;
+        stats.wagered = static_cast<double>(stats.rounds);
+        return stats;
+    }
+};
@@ -0,0 +1,494 @@
+/*
+* @file Cluster.h
+* @brief Fans one simulation out over worker processes and merges what they send back.
+*
+* This file defines `Coordinator`, which listens on 127.0.0.1, starts worker processes (this same
+* executable run with --worker) and hands each of them shards: ranges of shoe numbers of one
+* seeded shoe sequence. A worker plays its shard with runShoes() on its own work-stealing pool
+* and sends the SimResult back. Shoe n is the same whichever process plays it, so the merged
+* result is the one a single process would get. A shard whose worker disconnects or takes longer
+* than the timeout goes back on the queue for another worker, dead workers are replaced up to a
+* limit, and a result that arrives for a shard that is already done is dropped.
+*
+* Protocol (binary, little-endian, one frame per message):
+*
+*   uint32 type, uint32 payload length, payload
+*
+*   Hello   worker -> coordinator   uint32 CLUSTER_MAGIC, uint32 version, uint32 threads
+*   Shard   coordinator -> worker   uint64 shard, uint64 seed, uint64 first shoe, uint64 shoes,
+*                                   uint32 decks, uint32 strategy (0 basic, 1 with indices)
+*   Result  worker -> coordinator   uint64 shard, then SimResult: uint64 rounds, wins, losses,
+*                                   pushes, blackjacks, surrenders, double wagered, net, netSquared
+*   Stop    coordinator -> worker   empty; the worker exits
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <spawn.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+const uint32_t CLUSTER_MAGIC = 0x534A4442;     // "BDJS"
+const uint32_t CLUSTER_VERSION = 1;
+
+enum class FrameType : uint32_t
+{
+    Hello = 1, Shard = 2, Result = 3, Stop = 4
+};
+
+struct ShardRequest
+{
+    uint64_t shard = 0;
+    uint64_t seed = 0;
+    uint64_t first = 0;
+    uint64_t shoes = 0;
+    uint32_t decks = 1;
+    uint32_t strategy = 0;
+};
+
+// Frames are built and read with plain byte copies, like the columnar files
+class FrameWriter
+{
+private:
+    std::vector<uint8_t> bytes;
+
+public:
+    explicit FrameWriter(FrameType type)
+    {
+        put(static_cast<uint32_t>(type));
+        put(static_cast<uint32_t>(0));
+    }
+    template<typename T>
+    void put(T value)
+    {
+        size_t at = bytes.size();
+        bytes.resize(at + sizeof(T));
+        std::memcpy(bytes.data() + at, &value, sizeof(T));
+    }
+    // The finished frame, with its payload length filled in
+    const std::vector<uint8_t>& finish()
+    {
+        uint32_t length = static_cast<uint32_t>(bytes.size() - 8);
+        std::memcpy(bytes.data() + 4, &length, sizeof(length));
+        return bytes;
+    }
+};
+
+class FrameReader
+{
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t at = 0;
+
+public:
+    FrameReader(const uint8_t* payload, size_t length) : data(payload), size(length) {}
+    template<typename T>
+    T get()
+    {
+        T value = T();
+        if (at + sizeof(T) <= size)
+            std::memcpy(&value, data + at, sizeof(T));
+        at += sizeof(T);
+        return value;
+    }
+    bool ok() const { return at <= size; }
+};
+
+inline bool sendAll(SocketHandle s, const std::vector<uint8_t>& bytes)
+{
+    size_t sent = 0;
+    while (sent < bytes.size())
+    {
+        int n = ::send(s, reinterpret_cast<const char*>(bytes.data()) + sent, static_cast<int>(bytes.size() - sent), SEND_FLAGS);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+inline bool recvAll(SocketHandle s, uint8_t* bytes, size_t size)
+{
+    size_t got = 0;
+    while (got < size)
+    {
+        int n = ::recv(s, reinterpret_cast<char*>(bytes) + got, static_cast<int>(size - got), 0);
+        if (n <= 0)
+            return false;
+        got += n;
+    }
+    return true;
+}
+
+inline void writeSimResult(FrameWriter& f, const SimResult& r)
+{
+    f.put(r.rounds); f.put(r.wins); f.put(r.losses); f.put(r.pushes); f.put(r.blackjacks); f.put(r.surrenders);
+    f.put(r.wagered); f.put(r.net); f.put(r.netSquared);
+}
+
+inline SimResult readSimResult(FrameReader& f)
+{
+    SimResult r;
+    r.rounds = f.get<uint64_t>(); r.wins = f.get<uint64_t>(); r.losses = f.get<uint64_t>();
+    r.pushes = f.get<uint64_t>(); r.blackjacks = f.get<uint64_t>(); r.surrenders = f.get<uint64_t>();
+    r.wagered = f.get<double>(); r.net = f.get<double>(); r.netSquared = f.get<double>();
+    return r;
+}
+
+inline bool startSockets()
+{
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+// Start `exe` with `args` without waiting for it
+inline bool spawnProcess(const std::string& exe, const std::vector<std::string>& args)
+{
+#ifdef _WIN32
+    std::string command = "\"" + exe + "\"";
+    for (const std::string& a : args)
+        command += " " + a;
+    STARTUPINFOA startup = {};
+    startup.cb = sizeof(startup);
+    PROCESS_INFORMATION process = {};
+    if (!CreateProcessA(nullptr, &command[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process))
+        return false;
+    CloseHandle(process.hThread);
+    CloseHandle(process.hProcess);
+    return true;
+#else
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(exe.c_str()));
+    for (const std::string& a : args)
+        argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+    pid_t pid;
+    return posix_spawnp(&pid, exe.c_str(), nullptr, nullptr, argv.data(), environ) == 0;
+#endif
+}
+
+/*******************************************************************************************
+* Worker side: connect to the coordinator, play shards until it says stop or goes away
+********************************************************************************************/
+inline int runClusterWorker(int port, int threads)
+{
+    if (!startSockets())
+        return 1;
+    SocketHandle s = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (s == NO_SOCKET || ::connect(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        return 1;
+
+    WorkStealingPool pool(threads, 4);
+    FrameWriter hello(FrameType::Hello);
+    hello.put(CLUSTER_MAGIC);
+    hello.put(CLUSTER_VERSION);
+    hello.put(static_cast<uint32_t>(pool.getThreads()));
+    if (!sendAll(s, hello.finish()))
+        return 1;
+
+    CountStrategy indices;
+    indices.deviations = illustriousDeviations();
+    std::vector<uint8_t> payload;
+    while (true)
+    {
+        uint32_t header[2];
+        if (!recvAll(s, reinterpret_cast<uint8_t*>(header), sizeof(header)))
+            break;
+        payload.resize(header[1]);
+        if (!recvAll(s, payload.data(), payload.size()))
+            break;
+        if (static_cast<FrameType>(header[0]) != FrameType::Shard)
+            break;
+        FrameReader f(payload.data(), payload.size());
+        ShardRequest shard;
+        shard.shard = f.get<uint64_t>();
+        shard.seed = f.get<uint64_t>();
+        shard.first = f.get<uint64_t>();
+        shard.shoes = f.get<uint64_t>();
+        shard.decks = f.get<uint32_t>();
+        shard.strategy = f.get<uint32_t>();
+        if (!f.ok())
+            break;
+
+        Rules rules;
+        rules.decks = static_cast<int>(shard.decks);
+        SimResult result = runShoes(pool, shard.first, shard.shoes, shard.seed, shard.strategy == 1 ? &indices : nullptr, rules);
+        FrameWriter reply(FrameType::Result);
+        reply.put(shard.shard);
+        writeSimResult(reply, result);
+        if (!sendAll(s, reply.finish()))
+            break;
+    }
+    closeSocket(s);
+    return 0;
+}
+
+struct ClusterSettings
+{
+    uint64_t shoes = 100000;
+    uint64_t shardShoes = 10000;
+    uint64_t seed = 1;
+    int decks = 1;
+    bool indices = false;
+    int processes = 2;
+    int threadsPerProcess = 1;
+    double shardTimeout = 120;      // Seconds before a shard is given to someone else
+    int maxRespawns = 4;            // Replacement workers started over the whole run
+};
+
+class Coordinator
+{
+private:
+    struct Worker
+    {
+        SocketHandle socket;
+        bool ready = false;             // Said hello
+        int64_t shard = -1;             // In flight, -1 for none
+        std::chrono::steady_clock::time_point sentAt;
+        std::vector<uint8_t> inbox;     // Bytes received but not yet a whole frame
+    };
+
+    ClusterSettings settings;
+    std::string exe;
+    SocketHandle listener = NO_SOCKET;
+    int port = 0;
+    std::vector<Worker> workers;
+    std::deque<uint64_t> pending;
+    std::vector<bool> done;
+    uint64_t remaining = 0;
+    SimResult total;
+    int respawns = 0;
+    uint64_t resubmitted = 0;
+
+    bool listen()
+    {
+        if (!startSockets())
+            return false;
+        listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (listener == NO_SOCKET)
+            return false;
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = 0;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 64) != 0)
+            return false;
+#ifdef _WIN32
+        int length = sizeof(address);
+#else
+        socklen_t length = sizeof(address);
+#endif
+        if (::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+            return false;
+        port = ntohs(address.sin_port);
+        return true;
+    }
+
+    bool spawnWorker()
+    {
+        return spawnProcess(exe, { "--worker", std::to_string(port), std::to_string(settings.threadsPerProcess) });
+    }
+
+    void sendShard(Worker& w)
+    {
+        if (pending.empty())
+            return;
+        uint64_t id = pending.front();
+        pending.pop_front();
+        FrameWriter f(FrameType::Shard);
+        f.put(id);
+        f.put(settings.seed);
+        uint64_t first = id * settings.shardShoes;
+        f.put(first);
+        f.put(std::min(settings.shardShoes, settings.shoes - first));
+        f.put(static_cast<uint32_t>(settings.decks));
+        f.put(static_cast<uint32_t>(settings.indices ? 1 : 0));
+        w.shard = static_cast<int64_t>(id);
+        w.sentAt = std::chrono::steady_clock::now();
+        if (!sendAll(w.socket, f.finish()))
+            w.ready = false;        // Dropped in the next sweep
+    }
+
+    // Put the worker's shard back on the queue, close it and start a replacement if allowed
+    void drop(size_t i)
+    {
+        Worker& w = workers[i];
+        if (w.shard >= 0 && !done[static_cast<size_t>(w.shard)])
+        {
+            pending.push_front(static_cast<uint64_t>(w.shard));
+            resubmitted++;
+        }
+        closeSocket(w.socket);
+        workers.erase(workers.begin() + static_cast<std::ptrdiff_t>(i));
+        if (remaining > 0 && respawns < settings.maxRespawns && spawnWorker())
+            respawns++;
+    }
+
+    // Handle every whole frame in the worker's inbox; false if it broke the protocol
+    bool readFrames(Worker& w)
+    {
+        size_t at = 0;
+        while (w.inbox.size() - at >= 8)
+        {
+            uint32_t header[2];
+            std::memcpy(header, w.inbox.data() + at, sizeof(header));
+            if (w.inbox.size() - at - 8 < header[1])
+                break;
+            FrameReader f(w.inbox.data() + at + 8, header[1]);
+            at += 8 + header[1];
+            FrameType type = static_cast<FrameType>(header[0]);
+            if (type == FrameType::Hello)
+            {
+                if (f.get<uint32_t>() != CLUSTER_MAGIC || f.get<uint32_t>() != CLUSTER_VERSION)
+                    return false;
+                w.ready = true;
+                sendShard(w);
+            }
+            else if (type == FrameType::Result && w.ready)
+            {
+                uint64_t id = f.get<uint64_t>();
+                SimResult r = readSimResult(f);
+                if (!f.ok() || id >= done.size())
+                    return false;
+                if (!done[id])
+                {
+                    done[id] = true;
+                    remaining--;
+                    total.add(r);
+                }
+                w.shard = -1;
+                sendShard(w);
+            }
+            else
+                return false;
+        }
+        w.inbox.erase(w.inbox.begin(), w.inbox.begin() + static_cast<std::ptrdiff_t>(at));
+        return true;
+    }
+
+public:
+    // `executable` is how to start this program again, usually argv[0]
+    Coordinator(const ClusterSettings& s, const std::string& executable)
+        : settings(s), exe(executable)
+    {
+        settings.shardShoes = std::max<uint64_t>(settings.shardShoes, 1);
+    }
+
+    ~Coordinator()
+    {
+        for (Worker& w : workers)
+            closeSocket(w.socket);
+        if (listener != NO_SOCKET)
+            closeSocket(listener);
+    }
+
+    uint64_t getResubmitted() const { return resubmitted; }
+    int getRespawns() const { return respawns; }
+
+    // Run the whole job; returns false if it could not finish
+    bool run(SimResult& result)
+    {
+        uint64_t shards = (settings.shoes + settings.shardShoes - 1) / settings.shardShoes;
+        done.assign(shards, false);
+        remaining = shards;
+        for (uint64_t i = 0; i < shards; i++)
+            pending.push_back(i);
+        if (!listen())
+            return false;
+        for (int i = 0; i < settings.processes; i++)
+            spawnWorker();
+
+        std::chrono::steady_clock::time_point lastProgress = std::chrono::steady_clock::now();
+        while (remaining > 0)
+        {
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(listener, &readable);
+            SocketHandle highest = listener;
+            for (Worker& w : workers)
+            {
+                FD_SET(w.socket, &readable);
+                highest = std::max(highest, w.socket);
+            }
+            timeval wait = { 1, 0 };
+            int n = ::select(static_cast<int>(highest) + 1, &readable, nullptr, nullptr, &wait);
+#ifndef _WIN32
+            while (waitpid(-1, nullptr, WNOHANG) > 0)
+                ;
+#endif
+            if (n < 0)
+                return false;
+
+            if (FD_ISSET(listener, &readable))
+            {
+                SocketHandle s = ::accept(listener, nullptr, nullptr);
+                if (s != NO_SOCKET)
+                {
+                    Worker w;
+                    w.socket = s;
+                    workers.push_back(w);
+                    lastProgress = std::chrono::steady_clock::now();
+                }
+            }
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            for (size_t i = workers.size(); i-- > 0;)
+            {
+                Worker& w = workers[i];
+                bool ok = true;
+                if (FD_ISSET(w.socket, &readable))
+                {
+                    char buffer[4096];
+                    int got = ::recv(w.socket, buffer, sizeof(buffer), 0);
+                    uint64_t before = remaining;
+                    ok = got > 0;
+                    if (ok)
+                    {
+                        w.inbox.insert(w.inbox.end(), buffer, buffer + got);
+                        ok = readFrames(w);
+                    }
+                    if (remaining != before)
+                        lastProgress = now;
+                }
+                if (ok && w.shard >= 0 && std::chrono::duration<double>(now - w.sentAt).count() > settings.shardTimeout)
+                    ok = false;
+                if (!ok || (!w.ready && w.shard >= 0))
+                    drop(i);
+            }
+            // A worker that was idle when shards came back on the queue picks one up now
+            for (Worker& w : workers)
+            {
+                if (w.ready && w.shard < 0)
+                    sendShard(w);
+            }
+            // Nobody left and nobody coming
+            if (workers.empty() && std::chrono::duration<double>(now - lastProgress).count() > settings.shardTimeout)
+                return false;
+        }
+
+        FrameWriter stop(FrameType::Stop);
+        for (Worker& w : workers)
+            sendAll(w.socket, stop.finish());
+        result = total;
+        return true;
+    }
+};
@@ -0,0 +1,236 @@
+/*
+* @file ColumnarExport.h
+* @brief Writes simulation results as a documented columnar binary, one row group at a time.
+*
+* This file defines `ColumnarWriter`, a small column store streamed to disk, and `HandExporter`,
+* which turns each `HandRecord` from the Simulator into one row. Rows are buffered per column and
+* written as a row group every `rowGroupRows` rows, so memory stays flat however long the run is.
+* Actions and outcomes are dictionary encoded: one byte per row indexing a list of names.
+*
+* File layout, all integers little-endian:
+*
+*   "BJCOL1\n\0"                                8-byte magic
+*   row group *                                 see below
+*   footer
+*   uint64 footer offset                        from the start of the file
+*   "BJCOL1\n\0"                                magic again
+*
+*   row group: for each column in schema order, rows * width bytes of packed values
+*
+*   footer:
+*     uint32 column count, then per column:
+*       uint8 type, uint8 name length, name     type: 0 uint8, 1 uint32, 2 uint64, 3 float32, 4 dictionary (uint8 codes)
+*       for dictionaries: uint8 entries, then per entry uint8 length, text
+*     uint32 row group count, then per group: uint64 offset, uint32 rows
+*     uint64 total rows
+*
+* The schema lives in the footer, as in Parquet, so the writer never has to seek back.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+const char COLUMNAR_MAGIC[8] = { 'B', 'J', 'C', 'O', 'L', '1', '\n', '\0' };
+
+enum class ColumnType : uint8_t
+{
+    UInt8 = 0, UInt32 = 1, UInt64 = 2, Float32 = 3, Dictionary = 4
+};
+
+class ColumnarWriter
+{
+private:
+    struct Column
+    {
+        std::string name;
+        ColumnType type;
+        std::vector<std::string> dictionary;
+        std::vector<uint8_t> data;      // Packed values of the current row group
+    };
+    struct RowGroup
+    {
+        uint64_t offset;
+        uint32_t rows;
+    };
+
+    std::vector<Column> columns;
+    std::vector<RowGroup> groups;
+    FILE* file = nullptr;
+    uint64_t offset = 0;
+    uint64_t totalRows = 0;
+    uint32_t rows = 0;      // In the current row group
+    uint32_t rowGroupRows;
+
+    static int widthOf(ColumnType t)
+    {
+        switch (t)
+        {
+        case ColumnType::UInt32: case ColumnType::Float32: return 4;
+        case ColumnType::UInt64: return 8;
+        default: return 1;
+        }
+    }
+
+    // Values are stored in the machine's byte order, which is little-endian on every target we build for
+    template<typename T>
+    void put(size_t column, T value)
+    {
+        std::vector<uint8_t>& data = columns[column].data;
+        size_t at = data.size();
+        data.resize(at + sizeof(T));
+        std::memcpy(data.data() + at, &value, sizeof(T));
+    }
+
+    void write(const void* bytes, size_t size)
+    {
+        std::fwrite(bytes, 1, size, file);
+        offset += size;
+    }
+    template<typename T>
+    void writeValue(T value) { write(&value, sizeof(T)); }
+    void writeText(const std::string& text)
+    {
+        writeValue(static_cast<uint8_t>(std::min<size_t>(text.size(), 255)));
+        write(text.data(), std::min<size_t>(text.size(), 255));
+    }
+
+    void flushGroup()
+    {
+        if (rows == 0)
+            return;
+        groups.push_back(RowGroup{ offset, rows });
+        for (Column& c : columns)
+        {
+            write(c.data.data(), c.data.size());
+            c.data.clear();
+        }
+        rows = 0;
+    }
+
+public:
+    explicit ColumnarWriter(uint32_t groupRows = 65536)
+        : rowGroupRows(groupRows > 0 ? groupRows : 1)
+    {
+    }
+    ~ColumnarWriter() { close(); }
+    ColumnarWriter(const ColumnarWriter&) = delete;
+    ColumnarWriter& operator=(const ColumnarWriter&) = delete;
+
+    // Columns must all be added before open(); returns the column's number for the set functions
+    size_t addColumn(const std::string& name, ColumnType type, const std::vector<std::string>& dictionary = {})
+    {
+        columns.push_back(Column{ name, type, dictionary, {} });
+        columns.back().data.reserve(static_cast<size_t>(rowGroupRows) * widthOf(type));
+        return columns.size() - 1;
+    }
+
+    bool open(const char* path)
+    {
+        file = std::fopen(path, "wb");
+        if (!file)
+            return false;
+        write(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+        return true;
+    }
+
+    // Set every column once, then call endRow()
+    void setUInt8(size_t column, uint8_t value) { put(column, value); }
+    void setUInt32(size_t column, uint32_t value) { put(column, value); }
+    void setUInt64(size_t column, uint64_t value) { put(column, value); }
+    void setFloat32(size_t column, float value) { put(column, value); }
+
+    void endRow()
+    {
+        totalRows++;
+        if (++rows == rowGroupRows)
+            flushGroup();
+    }
+
+    uint64_t getRows() const { return totalRows; }
+
+    // Write the last row group and the footer
+    bool close()
+    {
+        if (!file)
+            return false;
+        flushGroup();
+        uint64_t footer = offset;
+        writeValue(static_cast<uint32_t>(columns.size()));
+        for (const Column& c : columns)
+        {
+            writeValue(static_cast<uint8_t>(c.type));
+            writeText(c.name);
+            if (c.type == ColumnType::Dictionary)
+            {
+                writeValue(static_cast<uint8_t>(c.dictionary.size()));
+                for (const std::string& entry : c.dictionary)
+                    writeText(entry);
+            }
+        }
+        writeValue(static_cast<uint32_t>(groups.size()));
+        for (const RowGroup& g : groups)
+        {
+            writeValue(g.offset);
+            writeValue(g.rows);
+        }
+        writeValue(totalRows);
+        writeValue(footer);
+        write(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+        bool ok = std::ferror(file) == 0;
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+};
+
+// One row per played round, hooked up with Simulator::setRecorder()
+class HandExporter
+{
+private:
+    ColumnarWriter writer;
+    size_t round, trueCount, bet, net, playerTotal, dealerTotal, upcard, playerCards, action, outcome;
+
+public:
+    explicit HandExporter(uint32_t groupRows = 65536)
+        : writer(groupRows)
+    {
+        round = writer.addColumn("round", ColumnType::UInt64);
+        trueCount = writer.addColumn("true_count", ColumnType::Float32);
+        bet = writer.addColumn("bet", ColumnType::Float32);
+        net = writer.addColumn("net", ColumnType::Float32);
+        playerTotal = writer.addColumn("player_total", ColumnType::UInt8);
+        dealerTotal = writer.addColumn("dealer_total", ColumnType::UInt8);
+        upcard = writer.addColumn("upcard", ColumnType::UInt8);
+        playerCards = writer.addColumn("player_cards", ColumnType::UInt8);
+        // Codes are the Action and RoundResult values; None is a round settled on the deal
+        action = writer.addColumn("first_action", ColumnType::Dictionary, { "None", "Hit", "Stand", "Double", "Surrender" });
+        outcome = writer.addColumn("outcome", ColumnType::Dictionary,
+            { "None", "Blackjack", "Win", "Loss", "Push", "Surrender" });
+    }
+
+    bool open(const char* path) { return writer.open(path); }
+    bool close() { return writer.close(); }
+
+    void add(const HandRecord& r)
+    {
+        writer.setUInt64(round, r.round);
+        writer.setFloat32(trueCount, r.trueCount);
+        writer.setFloat32(bet, r.bet);
+        writer.setFloat32(net, r.net);
+        writer.setUInt8(playerTotal, static_cast<uint8_t>(r.playerTotal));
+        writer.setUInt8(dealerTotal, static_cast<uint8_t>(r.dealerTotal));
+        writer.setUInt8(upcard, static_cast<uint8_t>(r.upcard));
+        writer.setUInt8(playerCards, static_cast<uint8_t>(r.playerCards));
+        writer.setUInt8(action, static_cast<uint8_t>(r.firstAction));
+        writer.setUInt8(outcome, static_cast<uint8_t>(r.result));
+        writer.endRow();
+    }
+};
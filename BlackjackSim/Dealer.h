@@ -5,6 +5,8 @@
 * This file defines the Dealer class, which represents the dealer in a Blackjack game.
 * The dealer manages their hand, calculates totals, and handles game actions such as hitting and standing.
 * It also includes methods for drawing the dealer's hand and managing the dealer's turn.
+* The dealer's play is a walk through `DealerTable`, a state-transition table built once for
+* each of the two house rules: standing on all 17s (S17) or hitting soft 17 (H17).
 *
 * @author Michael Lintelman
 * @date 2024-04-01
@@ -12,12 +14,79 @@
 
 #pragma once
 #include <vector>
+
+/*******************************************************************************************
+* The dealer's play as a state machine. A state is the best total so far and whether an Ace
+* in it is counting as 11; next() gives the state after one more card (by rank slot, see
+* rankSlot()) and stands() says whether the dealer stops there. BUST is the only state past 21.
+********************************************************************************************/
+class DealerTable
+{
+public:
+	static const int START = 0;			// No cards yet
+	static const int BUST = 22 * 2;
+	static const int STATES = BUST + 1;
+
+private:
+	int transitions[STATES][RANK_SLOTS];
+	bool standing[STATES];
+
+	explicit DealerTable(bool hitSoft17)
+	{
+		for (int total = 0; total <= 21; total++)
+		{
+			for (int soft = 0; soft < 2; soft++)
+			{
+				int state = stateOf(total, soft == 1);
+				standing[state] = total > 17 || (total == 17 && !(soft && hitSoft17));
+				for (int r = 0; r < RANK_SLOTS; r++)
+				{
+					// An Ace counts as 11 if that doesn't bust, and a soft hand that would bust drops its 11 to 1
+					int value = r + 1;
+					bool nowSoft = soft == 1;
+					int next = total + value;
+					if (value == 1 && !nowSoft && next + 10 <= 21)
+					{
+						next += 10;
+						nowSoft = true;
+					}
+					if (next > 21 && nowSoft)
+					{
+						next -= 10;
+						nowSoft = false;
+					}
+					transitions[state][r] = next > 21 ? BUST : stateOf(next, nowSoft);
+				}
+			}
+		}
+		standing[BUST] = true;
+		for (int r = 0; r < RANK_SLOTS; r++)
+			transitions[BUST][r] = BUST;
+	}
+
+public:
+	static int stateOf(int total, bool soft) { return total * 2 + (soft ? 1 : 0); }
+	static int totalOf(int state) { return state / 2; }
+	static bool softOf(int state) { return (state & 1) != 0; }
+
+	// Both tables are built the first time they are asked for
+	static const DealerTable& get(bool hitSoft17)
+	{
+		static const DealerTable s17(false), h17(true);
+		return hitSoft17 ? h17 : s17;
+	}
+
+	int next(int state, int rank) const { return transitions[state][rank]; }
+	bool stands(int state) const { return standing[state]; }
+};
+
 class Dealer
 {
 private:
-	int handTotal = 0;
 	bool turnOver = false;
 	bool busted = false;
+	bool verbose = true;
+	bool hitSoft17 = false;
 	int drawX = 300;
 	int drawY = 550;
 
@@ -29,14 +98,23 @@ public:
 	int getDrawX() const { return drawX; }
 	int getDrawY() const { return drawY; }
 	bool getTurnOver() const { return turnOver; }
+	bool getVerbose() const { return verbose; }
 
 	void setDrawX(int x) { drawX = x; }
 	void setDrawY(int y) { drawY = y; }
 	void setTurnOver(bool value) { turnOver = value; }
+	void setBusted(bool value) { busted = value; }
+	// Turn off console output for headless simulation
+	void setVerbose(bool value) { verbose = value; }
+	// House rule: hit soft 17 (H17) instead of standing on it (S17)
+	void setHitSoft17(bool value) { hitSoft17 = value; }
+	bool getHitSoft17() const { return hitSoft17; }
 
 	Dealer(Deck d)
 	{
-
+		// Room for any hand a round can realistically deal, so dealing never has to grow them
+		hand.reserve(12);
+		handCopy.reserve(12);
 	}
 
 	void newRound()
@@ -163,10 +241,12 @@ public:
 	void hit(Deck& d)
 	{
 		hand.push_back(d.deal());
-		std::cout << "The dealer hit and received a ";
-		hand.back().display();
-		std::cout << std::endl;
-		handTotal += hand.back().getValue();
+		if (verbose)
+		{
+			std::cout << "The dealer hit and received a ";
+			hand.back().display();
+			std::cout << std::endl;
+		}
 	}
 
 	/*******************************************************************************************
@@ -174,7 +254,8 @@ public:
 	********************************************************************************************/
 	void stand(void)
 	{
-		std::cout << "The dealer stood!" << std::endl << std::endl;
+		if (verbose)
+			std::cout << "The dealer stood!" << std::endl << std::endl;
 		turnOver = true;
 	}
 
@@ -183,7 +264,8 @@ public:
 	********************************************************************************************/
 	void bust(void)
 	{
-		std::cout << "The dealer busted and lost!" << std::endl << std::endl;
+		if (verbose)
+			std::cout << "The dealer busted and lost!" << std::endl << std::endl;
 		turnOver = true;
 		busted = true;
 	}
@@ -191,40 +273,39 @@ public:
 	void takeTurn(Deck& d);
 };
 
-// Dealer's turn
+// Dealer's turn: walk the hand through the dealer table, then draw until it says stand
 void Dealer::takeTurn(Deck& d)
 {
-	while (!turnOver)
-	{
+	BJ_PROFILE_SCOPE(Phase::DealerTurn);
+	const DealerTable& table = DealerTable::get(hitSoft17);
+	int state = DealerTable::START;
+	if (verbose)
 		std::cout << "Dealer's hand:" << std::endl;
-		for (const Card& c : hand)
-		{
-			handTotal += c.getValue();
+	for (const Card& c : hand)
+	{
+		state = table.next(state, rankSlot(c));
+		if (verbose)
 			c.display();
-		}
-		std::cout << "Dealer's total:  " << handTotal << std::endl << std::endl;
+	}
+	if (verbose)
+		std::cout << "Dealer's total:  " << DealerTable::totalOf(state) << std::endl << std::endl;
 
-		// If the hand total is 21 off the first two cards, it is a blackjack
-		if (handTotal == 21 && hand.size() == 2)
-		{
-			// The turn is over, and return the whole function
+	// If the hand total is 21 off the first two cards, it is a blackjack
+	if (DealerTable::totalOf(state) == 21 && hand.size() == 2)
+	{
+		if (verbose)
 			std::cout << "The dealer got a Blackjack!" << std::endl << std::endl;
-			turnOver = true;
-			return;
-		}
+		turnOver = true;
+		return;
+	}
 
-		// While the total is 16 or lower, the dealer hits
-		if (handTotal <= 16)
-		{
-			hit(d);
-			drawHand(textures);
-			//std::this_thread::sleep_for(std::chrono::seconds(2));
-		}
-		else
-			stand();
-		// If dealer's hand total is over 21, they bust and the turn is over.
-		if (handTotal > 21)
-			bust();
-		handTotal = 0;
-	}
-}
\ No newline at end of file
+	while (!table.stands(state))
+	{
+		hit(d);
+		state = table.next(state, rankSlot(hand.back()));
+	}
+	if (state == DealerTable::BUST)
+		bust();
+	else
+		stand();
+}
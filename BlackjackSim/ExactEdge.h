@@ -0,0 +1,422 @@
+/*
+* @file ExactEdge.h
+* @brief Exact expected value of a fresh shoe for a fixed strategy, without sampling.
+*
+* This file defines the `ExactCalculator` class. It walks every way the cards can come out of
+* the shoe: the four cards of the deal, every card the player draws and every card the dealer
+* draws, weighting each by its probability. Suits never matter to a total, so the shoe is just a
+* count of each of the ten ranks, and one branch covers every suit. The dealer's final outcome
+* only depends on those counts and the dealer's hand, so it is kept in a transposition table and
+* shared by every player hand that leaves the same cards behind. The deals are split over worker
+* threads, each with its own table.
+*
+* The player and dealer follow the same rules as Player, Dealer and Table, the peek and insurance
+* included, and the true count for a CountStrategy comes from the cards already dealt, the hole
+* card included, as it does in the Simulator. actionValues() answers a single decision for any
+* shoe composition, playing the rest of the hand to the best EV instead of a fixed strategy;
+* under a peek it knows the dealer has no natural.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class ExactCalculator
+{
+private:
+    // Rank slots as rankSlot() numbers them
+    static const int RANKS = RANK_SLOTS;
+    // Dealer outcome slots: totals 17..21, bust, blackjack
+    static const int BUST = 5;
+    static const int NATURAL = 6;
+    using Outcome = std::array<double, 7>;
+
+    struct Shoe
+    {
+        int counts[RANKS];
+        int left;
+    };
+
+    // One worker's view: the shoe it is walking and its transposition table
+    struct Worker
+    {
+        Shoe shoe;
+        std::unordered_map<uint64_t, Outcome> dealerCache;
+    };
+
+    Rules rules;
+    const CountStrategy* strategy;
+    Worker advice;          // Used by actionValues(), which keeps its tables between calls
+    std::unordered_map<uint64_t, double> playerCache;
+    int fullCounts[RANKS];
+    int fullLeft;
+
+    static int tagOf(int rank) { return rank == 0 || rank == 9 ? -1 : (rank <= 5 ? 1 : 0); }
+    // Total as Player::getTotal and Dealer::getTotal count it, an Ace is 11 when it fits
+    static int totalOf(int hard, bool ace) { return ace && hard + 10 <= 21 ? hard + 10 : hard; }
+
+    // The counts as digits of a mixed-radix number, 0..32 per rank and 0..128 for tens, which is
+    // every shoe of up to 8 decks in under 53 bits and leaves 11 for the hand
+    static uint64_t shoeKey(const Shoe& shoe)
+    {
+        uint64_t key = 0;
+        for (int r = 0; r < RANKS; r++)
+            key = key * (r == 9 ? 129 : 33) + static_cast<uint64_t>(shoe.counts[r]);
+        return key;
+    }
+    // The shoe with a hand in the low bits: its hard total, whether it holds an Ace, and up to 3 cards
+    static uint64_t keyOf(const Shoe& shoe, int hard, bool ace, int cards)
+    {
+        return (shoeKey(shoe) << 8) | (static_cast<uint64_t>(hard) << 3) | (ace ? 4u : 0u)
+            | static_cast<uint64_t>(std::min(cards, 3));
+    }
+
+    // Same count the Simulator would see: everything dealt so far, over the decks left
+    double trueCount(const Shoe& shoe) const
+    {
+        int running = 0;
+        for (int r = 0; r < RANKS; r++)
+            running += (fullCounts[r] - shoe.counts[r]) * tagOf(r);
+        return shoe.left > 0 ? running * 52.0 / shoe.left : 0.0;
+    }
+
+    // Probability of every dealer outcome when the dealer plays on from this hand (Dealer::takeTurn)
+    Outcome dealerOutcome(Worker& w, int hard, bool ace, int cards)
+    {
+        Outcome out = {};
+        if (hard > 21)
+        {
+            out[BUST] = 1;
+            return out;
+        }
+        int total = totalOf(hard, ace);
+        bool soft = total != hard;
+        if (total > 17 || (total == 17 && !(soft && rules.dealerHitsSoft17)))
+        {
+            out[cards == 2 && total == 21 ? NATURAL : total - 17] = 1;
+            return out;
+        }
+
+        uint64_t key = keyOf(w.shoe, hard, ace, cards);
+        auto found = w.dealerCache.find(key);
+        if (found != w.dealerCache.end())
+            return found->second;
+
+        // Under a peek a one-card dealer hand is one whose hole card has been checked: it can't be
+        // the ten under an Ace or the Ace under a ten
+        Shoe& shoe = w.shoe;
+        int ruledOut = -1;
+        if (cards == 1 && rules.dealerPeeks)
+            ruledOut = hard == 1 ? 9 : (hard == 10 ? 0 : -1);
+        if (ruledOut >= 0 && shoe.counts[ruledOut] == shoe.left)
+            ruledOut = -1;
+        int left = shoe.left - (ruledOut >= 0 ? shoe.counts[ruledOut] : 0);
+        for (int r = 0; r < RANKS; r++)
+        {
+            if (shoe.counts[r] == 0 || r == ruledOut)
+                continue;
+            double p = static_cast<double>(shoe.counts[r]) / left;
+            shoe.counts[r]--;
+            shoe.left--;
+            Outcome next = dealerOutcome(w, hard + r + 1, ace || r == 0, cards + 1);
+            shoe.counts[r]++;
+            shoe.left++;
+            for (int i = 0; i < 7; i++)
+                out[i] += p * next[i];
+        }
+        w.dealerCache.emplace(key, out);
+        return out;
+    }
+
+    // EV of standing on `total` against the dealer's hand, as Table::settle pays it
+    double standValue(Worker& w, int total, bool blackjack, int dealerHard, bool dealerAce, int dealerCards = 2)
+    {
+        Outcome d = dealerOutcome(w, dealerHard, dealerAce, dealerCards);
+        if (blackjack)
+            return (1 - d[NATURAL]) * rules.blackjackPays;
+        double ev = d[BUST] - d[NATURAL];
+        for (int t = 17; t <= 21; t++)
+            ev += d[t - 17] * (total > t ? 1 : (total < t ? -1 : 0));
+        return ev;
+    }
+
+    // EV of the player's hand from here on, playing the strategy
+    double playerValue(Worker& w, int hard, bool ace, int cards, int up, int dealerHard, bool dealerAce)
+    {
+        int total = totalOf(hard, ace);
+        bool soft = ace && hard + 10 <= 21;
+        bool first = cards == 2;
+        bool canDouble = first && rules.doubleAllowed;
+        bool canSurrender = first && rules.surrenderAllowed;
+        int upcard = up + 1;
+        Action action = strategy
+            ? strategy->play(total, soft, upcard, canDouble, canSurrender, trueCount(w.shoe))
+            : basicStrategy(total, soft, upcard, canDouble, canSurrender);
+        // Player::hit refuses once the hard total reaches 21
+        if (hard >= 21 && action == Action::Hit)
+            action = Action::Stand;
+
+        switch (action)
+        {
+        case Action::Surrender:
+            return -0.5;
+        case Action::Stand:
+            return standValue(w, total, first && total == 21, dealerHard, dealerAce);
+        default:
+            break;
+        }
+
+        bool doubled = action == Action::DoubleDown;
+        Shoe& shoe = w.shoe;
+        double ev = 0;
+        for (int r = 0; r < RANKS; r++)
+        {
+            if (shoe.counts[r] == 0)
+                continue;
+            double p = static_cast<double>(shoe.counts[r]) / shoe.left;
+            shoe.counts[r]--;
+            shoe.left--;
+            int nextHard = hard + r + 1;
+            bool nextAce = ace || r == 0;
+            double value;
+            if (nextHard > 21)
+                value = doubled ? -2 : -1;
+            else if (doubled)
+                value = 2 * standValue(w, totalOf(nextHard, nextAce), false, dealerHard, dealerAce);
+            else
+                value = playerValue(w, nextHard, nextAce, cards + 1, up, dealerHard, dealerAce);
+            shoe.counts[r]++;
+            shoe.left++;
+            ev += p * value;
+        }
+        return ev;
+    }
+
+    // Take one card of rank `r` out of the shoe, returning the probability it was dealt
+    static double draw(Shoe& shoe, int r)
+    {
+        double p = static_cast<double>(shoe.counts[r]) / shoe.left;
+        shoe.counts[r]--;
+        shoe.left--;
+        return p;
+    }
+
+    static void putBack(Shoe& shoe, int r)
+    {
+        shoe.counts[r]++;
+        shoe.left++;
+    }
+
+    // EV of every deal that starts with the player's first card `p1` and the dealer's up card `up`,
+    // weighted by the chance of the remaining two cards. Insurance and the peek go as in Table.
+    double dealValue(Worker& w, int p1, int up)
+    {
+        double ev = 0;
+        Shoe& shoe = w.shoe;
+        for (int p2 = 0; p2 < RANKS; p2++)
+        {
+            if (shoe.counts[p2] == 0)
+                continue;
+            double pp2 = draw(shoe, p2);
+            bool playerBJ = (p1 == 0 && p2 == 9) || (p1 == 9 && p2 == 0);
+            // Decided on the count before the hole card, like Simulator::getVisibleTrueCount()
+            bool insured = up == 0 && rules.insuranceOffered && strategy && strategy->takeInsurance(trueCount(shoe));
+            if (insured && playerBJ)
+            {
+                // Even money
+                ev += pp2;
+                putBack(shoe, p2);
+                continue;
+            }
+            for (int hole = 0; hole < RANKS; hole++)
+            {
+                if (shoe.counts[hole] == 0)
+                    continue;
+                double pHole = draw(shoe, hole);
+                bool dealerBJ = (up == 0 && hole == 9) || (up == 9 && hole == 0);
+                double value;
+                if (dealerBJ && rules.dealerPeeks)
+                    value = playerBJ ? 0 : -1;
+                else
+                    value = playerValue(w, p1 + p2 + 2, p1 == 0 || p2 == 0, 2, up, up + hole + 2, up == 0 || hole == 0);
+                // Half the bet at 2:1
+                if (insured)
+                    value += dealerBJ ? 1 : -0.5;
+                ev += pp2 * pHole * value;
+                putBack(shoe, hole);
+            }
+            putBack(shoe, p2);
+        }
+        return ev;
+    }
+
+    // Best EV from here when the player may only hit or stand, the hole card still in the shoe
+    double optimalValue(Worker& w, int hard, bool ace, int up)
+    {
+        int total = totalOf(hard, ace);
+        double stand = standValue(w, total, false, up + 1, up == 0, 1);
+        if (hard >= 21)
+            return stand;
+
+        uint64_t key = (shoeKey(w.shoe) << 10) | (static_cast<uint64_t>(hard) << 5) | (ace ? 16u : 0u)
+            | static_cast<uint64_t>(up);
+        auto found = playerCache.find(key);
+        if (found != playerCache.end())
+            return found->second;
+
+        double hit = hitValue(w, hard, ace, up, false);
+        double best = std::max(stand, hit);
+        playerCache.emplace(key, best);
+        return best;
+    }
+
+    // EV of taking one card and then playing on optimally, or standing after it when doubled
+    double hitValue(Worker& w, int hard, bool ace, int up, bool doubled)
+    {
+        Shoe& shoe = w.shoe;
+        double ev = 0;
+        for (int r = 0; r < RANKS; r++)
+        {
+            if (shoe.counts[r] == 0)
+                continue;
+            double p = draw(shoe, r);
+            int nextHard = hard + r + 1;
+            bool nextAce = ace || r == 0;
+            double value;
+            if (nextHard > 21)
+                value = -1;
+            else if (doubled)
+                value = standValue(w, totalOf(nextHard, nextAce), false, up + 1, up == 0, 1);
+            else
+                value = optimalValue(w, nextHard, nextAce, up);
+            putBack(shoe, r);
+            ev += p * value;
+        }
+        return doubled ? 2 * ev : ev;
+    }
+
+public:
+    // EV of every action for one player decision, and the best of them
+    struct ActionValues
+    {
+        double hit = 0;
+        double stand = 0;
+        double doubleDown = 0;      // Only meaningful when canDouble
+        double surrender = -0.5;    // Only meaningful when canSurrender
+        bool canDouble = false;
+        bool canSurrender = false;
+        Action best = Action::Stand;
+        double bestValue = 0;
+
+        // Set best to the legal action with the highest value; a hand of `hard` 21 or more can't hit
+        void chooseBest(int hard)
+        {
+            best = Action::Stand;
+            bestValue = stand;
+            if (hard < 21 && hit > bestValue)
+            {
+                best = Action::Hit;
+                bestValue = hit;
+            }
+            if (canDouble && doubleDown > bestValue)
+            {
+                best = Action::DoubleDown;
+                bestValue = doubleDown;
+            }
+            if (canSurrender && surrender > bestValue)
+            {
+                best = Action::Surrender;
+                bestValue = surrender;
+            }
+        }
+    };
+
+    /*******************************************************************************************
+    * EV of each action for the player's hand against the up card (rank slots, see rankSlot()),
+    * given how many cards of each rank are still unseen. The hole card counts as unseen. After a
+    * hit the rest of the hand is played to the best EV for that shoe. Not thread safe: the
+    * transposition tables are kept between calls and cleared when they grow too large.
+    ********************************************************************************************/
+    ActionValues actionValues(const int unseen[RANKS], int hard, bool ace, int cards, int up)
+    {
+        if (advice.dealerCache.size() > (1u << 20) || playerCache.size() > (1u << 20))
+        {
+            advice.dealerCache.clear();
+            playerCache.clear();
+        }
+        Worker& w = advice;
+        std::copy(unseen, unseen + RANKS, w.shoe.counts);
+        w.shoe.left = 0;
+        for (int r = 0; r < RANKS; r++)
+            w.shoe.left += unseen[r];
+
+        ActionValues v;
+        int total = totalOf(hard, ace);
+        bool first = cards == 2;
+        v.stand = standValue(w, total, first && total == 21, up + 1, up == 0, 1);
+        v.hit = hard >= 21 ? -1.0 : hitValue(w, hard, ace, up, false);
+        v.canDouble = first && rules.doubleAllowed;
+        v.canSurrender = first && rules.surrenderAllowed;
+        if (v.canDouble)
+            v.doubleDown = hitValue(w, hard, ace, up, true);
+
+        v.chooseBest(hard);
+        return v;
+    }
+
+    // `countStrategy` may be nullptr for plain basic strategy. Shoes of up to 8 decks, the most a Deck holds,
+    // fit the cache keys.
+    ExactCalculator(const Rules& r, const CountStrategy* countStrategy = nullptr)
+        : rules(r), strategy(countStrategy)
+    {
+        int decks = std::max(1, std::min(rules.decks, MAX_SHOE_CARDS / 52));
+        for (int i = 0; i < RANKS; i++)
+            fullCounts[i] = (i == 9 ? 16 : 4) * decks;
+        fullLeft = 52 * decks;
+    }
+
+    // Player's expected result per unit bet, off the top of a freshly shuffled shoe
+    double run(int threads = 0)
+    {
+        // One task per first player card and dealer up card
+        std::vector<double> results(RANKS * RANKS, 0.0);
+        std::atomic<int> nextTask(0);
+        auto work = [&]() {
+            Worker w;
+            std::copy(fullCounts, fullCounts + RANKS, w.shoe.counts);
+            w.shoe.left = fullLeft;
+            for (int task = nextTask++; task < RANKS * RANKS; task = nextTask++)
+            {
+                int p1 = task / RANKS, up = task % RANKS;
+                double p = draw(w.shoe, p1);
+                p *= draw(w.shoe, up);
+                results[task] = p * dealValue(w, p1, up);
+                putBack(w.shoe, up);
+                putBack(w.shoe, p1);
+            }
+        };
+
+        if (threads <= 0)
+            threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++)
+            pool.emplace_back(work);
+        work();
+        for (std::thread& t : pool)
+            t.join();
+
+        // Summed in task order so the answer doesn't depend on the thread count
+        double ev = 0;
+        for (double r : results)
+            ev += r;
+        return ev;
+    }
+};
@@ -0,0 +1,185 @@
+/*
+* @file FrameStats.h
+* @brief Frame pacing and frame-time telemetry for the renderer.
+*
+* This file defines the `FrameHistogram` class, a fixed-bucket histogram of frame times,
+* the `FrameStats` class, which records CPU and GPU time for every frame and reports
+* p50/p99 values, and the `FramePacer` class, which decides when the next frame is due.
+* GPU time is measured as the time spent waiting in glFinish() after the frame has been
+* submitted, so it only covers the part of the GPU work that did not overlap the CPU.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Histogram of frame times in 50 microsecond buckets, up to 100 ms (slower frames share the last bucket)
+class FrameHistogram
+{
+public:
+    static const int BUCKET_US = 50;
+    static const int NUM_BUCKETS = 2000;
+
+private:
+    std::array<uint32_t, NUM_BUCKETS + 1> buckets{};
+    uint64_t count = 0;
+    double totalUs = 0;
+    double maxUs = 0;
+
+public:
+    uint64_t getCount() const { return count; }
+    double getMeanUs() const { return count ? totalUs / count : 0.0; }
+    double getMaxUs() const { return maxUs; }
+    uint32_t getBucket(int i) const { return buckets[i]; }
+
+    void record(double us)
+    {
+        int bucket = static_cast<int>(us / BUCKET_US);
+        if (bucket > NUM_BUCKETS || bucket < 0)
+            bucket = NUM_BUCKETS;
+        buckets[bucket]++;
+        count++;
+        totalUs += us;
+        if (us > maxUs)
+            maxUs = us;
+    }
+
+    // Returns the upper edge of the bucket holding the given percentile (0-100)
+    double percentile(double p) const
+    {
+        if (count == 0)
+            return 0.0;
+        uint64_t target = static_cast<uint64_t>(p / 100.0 * count);
+        if (target >= count)
+            target = count - 1;
+        uint64_t seen = 0;
+        for (int i = 0; i <= NUM_BUCKETS; i++)
+        {
+            seen += buckets[i];
+            if (seen > target)
+                return i == NUM_BUCKETS ? maxUs : (i + 1) * static_cast<double>(BUCKET_US);
+        }
+        return maxUs;
+    }
+
+    void clear()
+    {
+        buckets.fill(0);
+        count = 0;
+        totalUs = 0;
+        maxUs = 0;
+    }
+};
+
+class FrameStats
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    FrameHistogram cpu;
+    FrameHistogram gpu;
+    Clock::time_point frameStart;
+    Clock::time_point cpuEnd;
+    bool gpuTiming = false;
+
+    static double elapsedUs(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::micro>(to - from).count();
+    }
+
+public:
+    const FrameHistogram& getCpu() const { return cpu; }
+    const FrameHistogram& getGpu() const { return gpu; }
+    bool getGpuTiming() const { return gpuTiming; }
+
+    // GPU timing forces a glFinish() every frame, so it is only switched on while someone is looking
+    void setGpuTiming(bool value) { gpuTiming = value; }
+
+    // Call at the top of the display callback
+    void beginFrame() { frameStart = Clock::now(); }
+
+    // Call once all draw calls for the frame have been issued
+    void endCpu()
+    {
+        cpuEnd = Clock::now();
+        cpu.record(elapsedUs(frameStart, cpuEnd));
+    }
+
+    // Call right before swapping buffers; waits for the GPU when GPU timing is on
+    void endGpu()
+    {
+        if (!gpuTiming)
+            return;
+        glFinish();
+        gpu.record(elapsedUs(cpuEnd, Clock::now()));
+    }
+
+    void clear()
+    {
+        cpu.clear();
+        gpu.clear();
+    }
+
+    // Print a one line summary of both histograms
+    void printSummary() const
+    {
+        std::printf("Frames: %llu  CPU p50 %.2f ms p99 %.2f ms max %.2f ms",
+            static_cast<unsigned long long>(cpu.getCount()),
+            cpu.percentile(50) / 1000.0, cpu.percentile(99) / 1000.0, cpu.getMaxUs() / 1000.0);
+        if (gpu.getCount() > 0)
+            std::printf("  GPU p50 %.2f ms p99 %.2f ms", gpu.percentile(50) / 1000.0, gpu.percentile(99) / 1000.0);
+        std::printf("\n");
+    }
+
+    // Export both histograms as CSV (bucket upper edge in microseconds, cpu count, gpu count)
+    bool writeCsv(const char* path) const
+    {
+        FILE* file = std::fopen(path, "w");
+        if (!file)
+            return false;
+        std::fprintf(file, "bucket_us,cpu_frames,gpu_frames\n");
+        for (int i = 0; i <= FrameHistogram::NUM_BUCKETS; i++)
+        {
+            if (cpu.getBucket(i) == 0 && gpu.getBucket(i) == 0)
+                continue;
+            std::fprintf(file, "%d,%u,%u\n", (i + 1) * FrameHistogram::BUCKET_US, cpu.getBucket(i), gpu.getBucket(i));
+        }
+        std::fprintf(file, "# cpu_p50_us,%.1f\n# cpu_p99_us,%.1f\n", cpu.percentile(50), cpu.percentile(99));
+        std::fprintf(file, "# gpu_p50_us,%.1f\n# gpu_p99_us,%.1f\n", gpu.percentile(50), gpu.percentile(99));
+        std::fclose(file);
+        return true;
+    }
+};
+
+// Schedules frames at a fixed rate. With vsync on, the swap itself blocks, so the pacer
+// only has to avoid queueing more than one frame ahead.
+class FramePacer
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration interval;
+    Clock::time_point nextFrame = Clock::now();
+
+public:
+    FramePacer(int targetHz)
+        : interval(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetHz)))
+    {
+    }
+
+    // Milliseconds to wait before the next frame should start
+    unsigned int msUntilNextFrame()
+    {
+        Clock::time_point now = Clock::now();
+        nextFrame += interval;
+        // If we fell more than a frame behind, resync instead of rendering a burst of catch-up frames
+        if (nextFrame < now)
+            nextFrame = now;
+        return static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::milliseconds>(nextFrame - now).count());
+    }
+};
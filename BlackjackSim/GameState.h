@@ -0,0 +1,101 @@
+/*
+* @file GameState.h
+* @brief Plain-data copy of the whole game, used to save, restore and fork a table.
+*
+* This file defines the `GameState` struct, which holds the shoe order and position, both hands, the bet,
+* balance, running count, round flags and the shuffle generator as fixed-size arrays of card
+* indices (see cardIndex). It is trivially copyable, so saving or restoring it is a copy of a few
+* hundred bytes. writeState() and readState() turn it into a compact binary blob that leaves out
+* the unused tail of the shoe array.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+const uint32_t GAME_STATE_MAGIC = 0x32534A42; // "BJS2"
+// Enough room for the longest possible hand out of an eight deck shoe
+const int MAX_HAND_CARDS = 22;
+
+// Number of RoundState and RoundResult values (Table.h checks these against the enums)
+const uint8_t ROUND_STATE_COUNT = 6;
+const uint8_t ROUND_RESULT_COUNT = 6;
+
+// Bits in GameState::flags
+enum GameStateFlag : uint8_t
+{
+    PLAYER_TURN_OVER = 1 << 0,
+    PLAYER_BUSTED = 1 << 1,
+    DEALER_TURN_OVER = 1 << 2,
+    DEALER_BUSTED = 1 << 3,
+    SURRENDERED = 1 << 4,
+    GAME_OVER = 1 << 5,
+    EVEN_MONEY = 1 << 6,
+};
+
+struct GameState
+{
+    uint32_t magic = GAME_STATE_MAGIC;
+    uint32_t round = 0;
+    Xoshiro256 rng = {};
+    float bal = 0;
+    float bet = 0;
+    float winnings = 0;
+    float insurance = 0;    // Side bet taken against a dealer Ace
+    int32_t runningCount = 0;
+    uint16_t shoeCount = 0;
+    uint16_t shoeNext = 0;  // Position of the next card to deal
+    uint16_t shoeStaged = 0;        // Continuous shuffler: cards on the delivery shelf
+    uint16_t shoeRoundStart = 0;    // Continuous shuffler: discards waiting to go back in
+    uint8_t state = 0;      // RoundState
+    uint8_t result = 0;     // RoundResult
+    uint8_t flags = 0;      // GameStateFlag bits
+    uint8_t playerCount = 0;
+    uint8_t dealerCount = 0;
+    uint8_t playerCards[MAX_HAND_CARDS] = {};
+    uint8_t dealerCards[MAX_HAND_CARDS] = {};
+    uint8_t shoe[MAX_SHOE_CARDS] = {};  // Whole shoe in dealing order
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value, "GameState must stay plain data");
+
+// Append the state to a blob, leaving out the unused part of the shoe
+inline void writeState(const GameState& state, std::vector<uint8_t>& blob)
+{
+    size_t size = offsetof(GameState, shoe) + state.shoeCount;
+    size_t start = blob.size();
+    blob.resize(start + size);
+    std::memcpy(blob.data() + start, &state, size);
+}
+
+// Read a state written by writeState(), returns false if the blob is not a valid state
+inline bool readState(const uint8_t* data, size_t size, GameState& state)
+{
+    const size_t header = offsetof(GameState, shoe);
+    if (size < header)
+        return false;
+    std::memcpy(static_cast<void*>(&state), data, header);
+    if (state.magic != GAME_STATE_MAGIC || state.shoeCount > MAX_SHOE_CARDS || state.shoeNext > state.shoeCount
+        || state.shoeNext + state.shoeStaged > state.shoeCount || state.shoeRoundStart > state.shoeNext
+        || size < header + state.shoeCount
+        || state.shoeCount == 0 || state.shoeCount % 52 != 0
+        || state.playerCount > MAX_HAND_CARDS || state.dealerCount > MAX_HAND_CARDS
+        || state.state >= ROUND_STATE_COUNT || state.result >= ROUND_RESULT_COUNT)
+        return false;
+    std::memcpy(state.shoe, data + header, state.shoeCount);
+    // Every card is a cardIndex(), 1 to 52; anything else would index past the card tables
+    auto validCards = [](const uint8_t* cards, int count) {
+        for (int i = 0; i < count; i++)
+            if (cards[i] < 1 || cards[i] > 52)
+                return false;
+        return true;
+    };
+    return validCards(state.shoe, state.shoeCount) && validCards(state.playerCards, state.playerCount)
+        && validCards(state.dealerCards, state.dealerCount);
+}
@@ -0,0 +1,519 @@
+/*
+* @file JobServer.h
+* @brief Long-running local daemon that runs simulation jobs sent over a localhost TCP socket.
+*
+* This file defines the `JobServer` class. It listens on 127.0.0.1, reads one job per line from
+* each client and puts it on a shared queue. A fixed pool of workers, each with its own warmed up
+* Simulator and RolloutAnalyzer, takes what-ifs off the queue in batches and sims one at a time,
+* and streams results back as they come in, so startup is paid once and small what-if queries
+* cost only their own work instead of waiting behind a long sim.
+*
+* Protocol (text, one line per message, fields are key=value separated by spaces):
+*
+*   sim id=<id> rounds=<n> [seed=<n>] [decks=<n>] [h17=1] [peek=0] [strategy=basic|indices] [ramp=1,1,2,4,6,8] [csm=1]
+*       -> progress id=<id> rounds=<n> net=<x> edge=<x>      every `chunkRounds` rounds
+*       -> done id=<id> rounds=<n> net=<x> edge=<x> sd=<x>
+*   whatif id=<id> state=<hex of writeState()> [rollouts=<n>] [seed=<n>]
+*       -> estimate id=<id> action=<name> ev=<x> se=<x>      one per legal action
+*       -> done id=<id>
+*   quit        closes this connection
+*   shutdown    stops the server
+*   Anything that can't be parsed gets "error id=<id> <reason>".
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+using SocketHandle = SOCKET;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+inline void closeSocket(SocketHandle s) { closesocket(s); }
+const int SEND_FLAGS = 0;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using SocketHandle = int;
+const SocketHandle NO_SOCKET = -1;
+inline void closeSocket(SocketHandle s) { close(s); }
+// Writing to a peer that has hung up fails with EPIPE instead of raising SIGPIPE, which would kill the process
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+#endif
+
+enum class JobType
+{
+    Sim, WhatIf
+};
+
+struct JobRequest
+{
+    JobType type = JobType::Sim;
+    std::string id;
+    uint64_t rounds = 0;
+    uint64_t seed = 1;
+    Rules rules;
+    bool indices = false;
+    bool csm = false;
+    bool hasRamp = false;
+    float ramp[BET_RAMP_SIZE] = { 1, 1, 1, 1, 1, 1 };
+    int rollouts = 1000;
+    GameState state;
+};
+
+/*******************************************************************************************
+* Parse one request line; on failure `error` says why
+********************************************************************************************/
+inline bool parseJob(const std::string& line, JobRequest& job, std::string& error)
+{
+    std::istringstream in(line);
+    std::string verb, field;
+    in >> verb;
+    if (verb == "sim")
+        job.type = JobType::Sim;
+    else if (verb == "whatif")
+        job.type = JobType::WhatIf;
+    else
+    {
+        error = "unknown request";
+        return false;
+    }
+
+    bool haveState = false;
+    while (in >> field)
+    {
+        size_t eq = field.find('=');
+        if (eq == std::string::npos)
+        {
+            error = "expected key=value: " + field;
+            return false;
+        }
+        std::string key = field.substr(0, eq), value = field.substr(eq + 1);
+        if (key == "id")
+            job.id = value;
+        else if (key == "rounds")
+            job.rounds = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "seed")
+            job.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "decks")
+            job.rules.decks = std::max(1, std::min(8, std::atoi(value.c_str())));
+        else if (key == "h17")
+            job.rules.dealerHitsSoft17 = value == "1";
+        else if (key == "peek")
+            job.rules.dealerPeeks = value != "0";
+        else if (key == "strategy")
+            job.indices = value == "indices";
+        else if (key == "csm")
+            job.csm = value == "1";
+        else if (key == "rollouts")
+            job.rollouts = std::max(1, std::atoi(value.c_str()));
+        else if (key == "ramp")
+        {
+            std::istringstream steps(value);
+            std::string step;
+            for (int i = 0; i < BET_RAMP_SIZE && std::getline(steps, step, ','); i++)
+                job.ramp[i] = std::max(0.0f, static_cast<float>(std::atof(step.c_str())));
+            job.hasRamp = true;
+        }
+        else if (key == "state")
+        {
+            std::vector<uint8_t> blob;
+            for (size_t i = 0; i + 1 < value.size(); i += 2)
+                blob.push_back(static_cast<uint8_t>(std::strtoul(value.substr(i, 2).c_str(), nullptr, 16)));
+            haveState = readState(blob.data(), blob.size(), job.state);
+            if (!haveState)
+            {
+                error = "bad state";
+                return false;
+            }
+        }
+        else
+        {
+            error = "unknown field " + key;
+            return false;
+        }
+    }
+    if (job.type == JobType::Sim && job.rounds == 0)
+    {
+        error = "rounds must be positive";
+        return false;
+    }
+    if (job.type == JobType::WhatIf && !haveState)
+    {
+        error = "whatif needs a state";
+        return false;
+    }
+    return true;
+}
+
+class JobServer
+{
+private:
+    // One client; the socket closes once the reader and every queued job are done with it
+    struct Connection
+    {
+        SocketHandle socket;
+        std::mutex writeLock;
+
+        explicit Connection(SocketHandle s) : socket(s) {}
+        ~Connection() { closeSocket(socket); }
+
+        void send(const std::string& text)
+        {
+            std::lock_guard<std::mutex> lock(writeLock);
+            size_t sent = 0;
+            while (sent < text.size())
+            {
+                int n = ::send(socket, text.data() + sent, static_cast<int>(text.size() - sent), SEND_FLAGS);
+                if (n <= 0)
+                    return;
+                sent += n;
+            }
+        }
+    };
+
+    struct Job
+    {
+        JobRequest request;
+        std::shared_ptr<Connection> client;
+    };
+
+    // Each worker keeps its engines between jobs
+    struct Worker
+    {
+        Simulator sim;
+        RolloutAnalyzer analyzer;
+    };
+
+    int port;
+    int threadCount;
+    uint64_t chunkRounds = 1000000;     // A sim job reports progress after every chunk
+    size_t maxBatch = 32;               // What-ifs a worker takes off the queue at once
+    SocketHandle listener = NO_SOCKET;
+    std::atomic<bool> running{ false };
+
+    std::mutex queueLock;
+    std::condition_variable queueReady;
+    std::deque<Job> queue;
+    std::vector<std::thread> workers;
+
+    // A client's reader thread, joined once it has finished
+    struct Reader
+    {
+        std::thread thread;
+        std::atomic<bool> finished{ false };
+    };
+
+    std::mutex clientLock;
+    std::vector<std::weak_ptr<Connection>> clients;
+    std::vector<std::unique_ptr<Reader>> readers;
+
+    void runSim(Worker& w, const Job& job)
+    {
+        const JobRequest& r = job.request;
+        Simulator& sim = w.sim;
+        CountStrategy strategy;
+        if (r.indices)
+            strategy.deviations = illustriousDeviations();
+        if (r.hasRamp)
+            std::copy(r.ramp, r.ramp + BET_RAMP_SIZE, strategy.ramp);
+        sim.setStrategy(r.indices || r.hasRamp ? &strategy : nullptr);
+        sim.setRules(r.rules);
+        sim.getDeck().setContinuous(r.csm);
+        sim.getDeck().setShoeSequence(r.seed, ShoeSampling::Independent);
+        sim.getDeck().reset();
+
+        SimResult stats;
+        char line[256];
+        while (stats.rounds < r.rounds && running)
+        {
+            uint64_t n = std::min(chunkRounds, r.rounds - stats.rounds);
+            for (uint64_t i = 0; i < n; i++)
+                sim.playRound(stats);
+            if (stats.rounds < r.rounds)
+            {
+                std::snprintf(line, sizeof(line), "progress id=%s rounds=%llu net=%.2f edge=%.6f\n", r.id.c_str(),
+                    static_cast<unsigned long long>(stats.rounds), stats.net, stats.getEdge());
+                job.client->send(line);
+            }
+        }
+        sim.setStrategy(nullptr);
+        std::snprintf(line, sizeof(line), "done id=%s rounds=%llu net=%.2f edge=%.6f sd=%.6f\n", r.id.c_str(),
+            static_cast<unsigned long long>(stats.rounds), stats.net, stats.getEdge(), stats.getStdDev());
+        job.client->send(line);
+    }
+
+    // What-if answers are small, so they are collected into `reply` and sent with the rest of the batch
+    void runWhatIf(Worker& w, const Job& job, std::string& reply)
+    {
+        static const char* const names[] = { "", "Hit", "Stand", "Double", "Surrender" };
+        const JobRequest& r = job.request;
+        std::vector<ActionEstimate> estimates = w.analyzer.estimate(r.state, r.rollouts, r.seed);
+        for (const ActionEstimate& e : estimates)
+        {
+            char line[160];
+            std::snprintf(line, sizeof(line), "estimate id=%s action=%s ev=%.6f se=%.6f\n", r.id.c_str(),
+                names[static_cast<int>(e.action)], e.mean, e.getStdErr());
+            reply += line;
+        }
+        if (estimates.empty())
+            reply += "error id=" + r.id + " state is not at a player decision\n";
+        reply += "done id=" + r.id + "\n";
+    }
+
+    void workerLoop()
+    {
+        Worker w;
+        std::vector<Job> batch;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(queueLock);
+                queueReady.wait(lock, [this] { return !queue.empty() || !running; });
+                if (!running)
+                    return;
+                // What-ifs are quick, so take as many as fit wherever they are in the queue; a sim
+                // runs for seconds and goes to a worker of its own when there is no what-if waiting
+                for (auto it = queue.begin(); it != queue.end() && batch.size() < maxBatch;)
+                {
+                    if (it->request.type == JobType::WhatIf)
+                    {
+                        batch.push_back(std::move(*it));
+                        it = queue.erase(it);
+                    }
+                    else
+                        ++it;
+                }
+                if (batch.empty())
+                {
+                    batch.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+                if (!queue.empty())
+                    queueReady.notify_one();
+            }
+
+            // Replies for the same client go out in one write
+            std::vector<std::pair<std::shared_ptr<Connection>, std::string>> replies;
+            for (const Job& job : batch)
+            {
+                if (job.request.type == JobType::Sim)
+                {
+                    runSim(w, job);
+                    continue;
+                }
+                auto it = std::find_if(replies.begin(), replies.end(),
+                    [&job](const std::pair<std::shared_ptr<Connection>, std::string>& p) { return p.first == job.client; });
+                if (it == replies.end())
+                {
+                    replies.emplace_back(job.client, std::string());
+                    it = replies.end() - 1;
+                }
+                runWhatIf(w, job, it->second);
+            }
+            for (auto& reply : replies)
+                reply.first->send(reply.second);
+            batch.clear();
+        }
+    }
+
+    void readerLoop(std::shared_ptr<Connection> client)
+    {
+        std::string pending;
+        char buffer[4096];
+        while (running)
+        {
+            int n = ::recv(client->socket, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+                return;
+            pending.append(buffer, n);
+            size_t end;
+            while ((end = pending.find('\n')) != std::string::npos)
+            {
+                std::string line = pending.substr(0, end);
+                pending.erase(0, end + 1);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                if (line.empty())
+                    continue;
+                if (line == "quit")
+                    return;
+                if (line == "shutdown")
+                {
+                    stop();
+                    return;
+                }
+
+                Job job;
+                std::string error;
+                if (!parseJob(line, job.request, error))
+                {
+                    client->send("error id=" + job.request.id + " " + error + "\n");
+                    continue;
+                }
+                job.client = client;
+                {
+                    std::lock_guard<std::mutex> lock(queueLock);
+                    queue.push_back(std::move(job));
+                }
+                queueReady.notify_one();
+            }
+        }
+    }
+
+public:
+    JobServer(int listenPort, int threads)
+        : port(listenPort), threadCount(threads > 0 ? threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency())))
+    {
+    }
+    ~JobServer()
+    {
+        stop();
+        for (std::unique_ptr<Reader>& r : readers)
+            r->thread.join();
+        for (std::thread& t : workers)
+            t.join();
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+
+    // Bind to 127.0.0.1:port and start the workers; returns false if the port can't be used
+    bool start()
+    {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+            return false;
+#endif
+        listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (listener == NO_SOCKET)
+            return false;
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 16) != 0)
+        {
+            closeSocket(listener);
+            listener = NO_SOCKET;
+            return false;
+        }
+
+        running = true;
+        for (int i = 0; i < threadCount; i++)
+            workers.emplace_back(&JobServer::workerLoop, this);
+        return true;
+    }
+
+    // Join the readers of clients that have gone and forget their connections
+    void reapClients()
+    {
+        std::lock_guard<std::mutex> lock(clientLock);
+        for (size_t i = 0; i < readers.size();)
+        {
+            if (readers[i]->finished)
+            {
+                readers[i]->thread.join();
+                readers[i] = std::move(readers.back());
+                readers.pop_back();
+            }
+            else
+                i++;
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+            [](const std::weak_ptr<Connection>& c) { return c.expired(); }), clients.end());
+    }
+
+    // Accept clients until stop(); each one gets its own reader thread
+    void run()
+    {
+        int backoff = 1;    // Milliseconds to wait after a failed accept, doubling up to a second
+        while (running)
+        {
+            SocketHandle s = ::accept(listener, nullptr, nullptr);
+            if (s == NO_SOCKET)
+            {
+                if (running)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(backoff));
+                backoff = std::min(backoff * 2, 1000);
+                continue;
+            }
+            backoff = 1;
+            if (!running)
+            {
+                closeSocket(s);
+                break;
+            }
+            reapClients();
+            std::shared_ptr<Connection> client = std::make_shared<Connection>(s);
+            std::lock_guard<std::mutex> lock(clientLock);
+            clients.push_back(client);
+            readers.emplace_back(new Reader());
+            Reader* reader = readers.back().get();
+            reader->thread = std::thread([this, reader, client] {
+                readerLoop(client);
+                reader->finished = true;
+            });
+        }
+    }
+
+    // Stop accepting, wake every thread and drop the queued jobs
+    void stop()
+    {
+        if (!running.exchange(false))
+            return;
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            queue.clear();
+        }
+        queueReady.notify_all();
+#ifdef _WIN32
+        closesocket(listener);
+#else
+        // shutdown() is what wakes a blocked accept() on Linux
+        ::shutdown(listener, SHUT_RDWR);
+        close(listener);
+#endif
+        std::lock_guard<std::mutex> lock(clientLock);
+        for (std::weak_ptr<Connection>& c : clients)
+        {
+            if (std::shared_ptr<Connection> client = c.lock())
+            {
+#ifdef _WIN32
+                ::shutdown(client->socket, SD_BOTH);
+#else
+                ::shutdown(client->socket, SHUT_RDWR);
+#endif
+            }
+        }
+    }
+
+    int getPort() const { return port; }
+    int getThreads() const { return threadCount; }
+};
@@ -0,0 +1,131 @@
+/*
+* @file Numa.h
+* @brief Which processors belong to which memory node, and pinning threads to them.
+*
+* This file defines `NumaTopology`. detect() reads the node layout from the operating system
+* (/sys/devices/system/node on Linux, the NUMA API on Windows) and falls back to one node
+* holding every hardware thread. place() hands out processors node by node, so the first workers
+* fill node 0 and the next ones node 1. A worker that pins itself before it allocates anything
+* gets its memory on its own node from first touch, without any explicit binding.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+class NumaTopology
+{
+private:
+    std::vector<std::vector<int>> nodeCpus;
+
+#ifndef _WIN32
+    // Parse a sysfs cpu list such as "0-15,32-47"
+    static std::vector<int> readCpuList(const char* path)
+    {
+        std::vector<int> cpus;
+        FILE* file = std::fopen(path, "r");
+        if (!file)
+            return cpus;
+        int first, last;
+        while (std::fscanf(file, "%d", &first) == 1)
+        {
+            last = first;
+            int c = std::fgetc(file);
+            if (c == '-' && std::fscanf(file, "%d", &last) == 1)
+                c = std::fgetc(file);
+            for (int cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+            if (c != ',')
+                break;
+        }
+        std::fclose(file);
+        return cpus;
+    }
+#endif
+
+public:
+    static NumaTopology detect()
+    {
+        NumaTopology t;
+#ifdef _WIN32
+        ULONG highest = 0;
+        if (GetNumaHighestNodeNumber(&highest))
+        {
+            for (ULONG node = 0; node <= highest; node++)
+            {
+                // Only processor group 0, which is every processor on machines with up to 64
+                ULONGLONG mask = 0;
+                std::vector<int> cpus;
+                if (GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask))
+                {
+                    for (int cpu = 0; cpu < 64; cpu++)
+                    {
+                        if (mask & (1ull << cpu))
+                            cpus.push_back(cpu);
+                    }
+                }
+                if (!cpus.empty())
+                    t.nodeCpus.push_back(cpus);
+            }
+        }
+#else
+        char path[96];
+        for (int node = 0; node < 1024; node++)
+        {
+            std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            std::vector<int> cpus = readCpuList(path);
+            if (!cpus.empty())
+                t.nodeCpus.push_back(cpus);
+            else if (node > 0 && !t.nodeCpus.empty())
+                break;
+        }
+#endif
+        if (t.nodeCpus.empty())
+        {
+            std::vector<int> cpus;
+            for (int cpu = 0; cpu < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); cpu++)
+                cpus.push_back(cpu);
+            t.nodeCpus.push_back(cpus);
+        }
+        return t;
+    }
+
+    int getNodes() const { return static_cast<int>(nodeCpus.size()); }
+    const std::vector<int>& getCpus(int node) const { return nodeCpus[node]; }
+
+    // Processor and node for worker `worker`; workers past the last processor wrap around
+    void place(int worker, int& cpu, int& node) const
+    {
+        size_t total = 0;
+        for (const std::vector<int>& cpus : nodeCpus)
+            total += cpus.size();
+        size_t i = static_cast<size_t>(worker) % total;
+        for (node = 0; i >= nodeCpus[node].size(); node++)
+            i -= nodeCpus[node].size();
+        cpu = nodeCpus[node][i];
+    }
+
+    // Pin the calling thread to one processor; returns false if the system refused
+    static bool pinCurrentThread(int cpu)
+    {
+#ifdef _WIN32
+        return cpu < 64 && SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1ull << cpu)) != 0;
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+    }
+};
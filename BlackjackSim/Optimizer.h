@@ -0,0 +1,209 @@
+/*
+* @file Optimizer.h
+* @brief Searches count-based bet ramps and index plays for the best EV per unit of risk.
+*
+* This file defines the `StrategyOptimizer` class. Each generation mutates the current best
+* `CountStrategy` (one deviation index or one ramp step) and races the mutants against it.
+* Every candidate plays the same shoes, seeded per chunk, so the comparison is paired and card
+* luck mostly cancels out. After each chunk a candidate whose paired score difference is clearly
+* negative is dropped, and the search only moves to a mutant that is clearly better.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+struct OptimizerSettings
+{
+    int candidates = 8;             // Mutants raced against the incumbent each generation
+    uint64_t chunkShoes = 4000;     // Shoes per chunk; every candidate plays the same shoes
+    int minChunks = 4;              // Chunks before anyone can be dropped
+    int maxChunks = 40;
+    double z = 2.5;                 // Standard errors needed to drop a candidate or accept one
+    float maxSpread = 12;           // Largest bet in units
+    int minIndex = -4;
+    int maxIndex = 8;
+    int threads = 0;                // 0 uses every hardware thread
+};
+
+class StrategyOptimizer
+{
+private:
+    // One candidate in a race: its score on every chunk played so far
+    struct Entry
+    {
+        CountStrategy strategy;
+        std::vector<double> scores;
+        bool alive = true;
+    };
+
+    OptimizerSettings settings;
+    Xoshiro256 rng;
+    uint64_t shoeSeed;
+
+    // Change one thing about the strategy by one step, keeping the ramp non-decreasing
+    CountStrategy mutate(const CountStrategy& from)
+    {
+        CountStrategy s = from;
+        int step = rng.below(2) ? 1 : -1;
+        size_t pick = rng.below(s.deviations.size() + BET_RAMP_SIZE - 1);
+        if (pick < s.deviations.size())
+        {
+            Deviation& d = s.deviations[pick];
+            d.index = std::max(settings.minIndex, std::min(settings.maxIndex, d.index + step));
+        }
+        else
+        {
+            // The bet at a true count of 0 or less stays at one unit
+            int i = static_cast<int>(pick - s.deviations.size()) + 1;
+            s.ramp[i] = std::max(1.0f, std::min(settings.maxSpread, s.ramp[i] + step));
+            for (int j = i + 1; j < BET_RAMP_SIZE; j++)
+                s.ramp[j] = std::max(s.ramp[j], s.ramp[i]);
+            for (int j = i - 1; j > 0; j--)
+                s.ramp[j] = std::min(s.ramp[j], s.ramp[i]);
+        }
+        return s;
+    }
+
+    // Play chunk `chunk` for every live entry, spread over the worker threads
+    void playChunk(std::vector<Entry>& entries, int chunk)
+    {
+        std::vector<Entry*> work;
+        for (Entry& e : entries)
+        {
+            if (e.alive)
+                work.push_back(&e);
+        }
+        std::atomic<size_t> nextEntry(0);
+        auto worker = [&]() {
+            Simulator sim;
+            for (size_t i = nextEntry++; i < work.size(); i = nextEntry++)
+            {
+                // Same shoe sequence for every candidate: common random numbers
+                SimResult stats;
+                sim.getDeck().setShoeSequence(shoeSeed, ShoeSampling::Independent);
+                sim.setStrategy(&work[i]->strategy);
+                for (uint64_t n = 0; n < settings.chunkShoes; n++)
+                    sim.playShoe(chunk * settings.chunkShoes + n, stats);
+                work[i]->scores.push_back(stats.getScore());
+            }
+        };
+
+        int threads = settings.threads > 0 ? settings.threads : static_cast<int>(std::thread::hardware_concurrency());
+        threads = std::max(1, std::min(threads, static_cast<int>(work.size())));
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++)
+            pool.emplace_back(worker);
+        worker();
+        for (std::thread& t : pool)
+            t.join();
+    }
+
+    // Mean and standard error of the chunk by chunk difference between two entries
+    static void pairedDifference(const Entry& a, const Entry& b, double& mean, double& stdErr)
+    {
+        size_t n = std::min(a.scores.size(), b.scores.size());
+        double sum = 0, sumSquares = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            double d = a.scores[i] - b.scores[i];
+            sum += d;
+            sumSquares += d * d;
+        }
+        mean = n > 0 ? sum / n : 0.0;
+        stdErr = n > 1 ? std::sqrt(std::max(0.0, (sumSquares - mean * sum) / (n - 1) / n)) : 0.0;
+    }
+
+public:
+    StrategyOptimizer(const OptimizerSettings& s, uint64_t seed)
+        : settings(s), shoeSeed(seed)
+    {
+        rng.seed(seed);
+    }
+
+    // Race one generation of mutants against `best`; returns true if one of them replaced it
+    bool step(CountStrategy& best)
+    {
+        std::vector<Entry> entries(settings.candidates + 1);
+        entries[0].strategy = best;
+        for (int i = 1; i <= settings.candidates; i++)
+            entries[i].strategy = mutate(best);
+        // Fresh shoes every generation so no candidate is tuned to one set of cards
+        shoeSeed = rng();
+
+        for (int chunk = 0; chunk < settings.maxChunks; chunk++)
+        {
+            playChunk(entries, chunk);
+            if (chunk + 1 < settings.minChunks)
+                continue;
+
+            int alive = 0;
+            for (size_t i = 1; i < entries.size(); i++)
+            {
+                if (!entries[i].alive)
+                    continue;
+                double mean, stdErr;
+                pairedDifference(entries[i], entries[0], mean, stdErr);
+                if (mean + settings.z * stdErr < 0)
+                    entries[i].alive = false;
+                else
+                    alive++;
+            }
+            if (alive == 0)
+                return false;
+        }
+
+        // Take the best survivor if it is clearly ahead of the incumbent
+        int winner = -1;
+        double winnerMean = 0;
+        for (size_t i = 1; i < entries.size(); i++)
+        {
+            if (!entries[i].alive)
+                continue;
+            double mean, stdErr;
+            pairedDifference(entries[i], entries[0], mean, stdErr);
+            if (mean - settings.z * stdErr > 0 && mean > winnerMean)
+            {
+                winner = static_cast<int>(i);
+                winnerMean = mean;
+            }
+        }
+        if (winner < 0)
+            return false;
+        best = entries[winner].strategy;
+        return true;
+    }
+
+    // Run `generations` generations from `start`, printing every improvement
+    CountStrategy run(CountStrategy start, int generations)
+    {
+        for (int g = 0; g < generations; g++)
+        {
+            if (step(start))
+            {
+                std::printf("Generation %d: ", g + 1);
+                printStrategy(start);
+            }
+        }
+        return start;
+    }
+
+    static void printStrategy(const CountStrategy& s)
+    {
+        std::printf("ramp");
+        for (int i = 0; i < BET_RAMP_SIZE; i++)
+            std::printf(" %.0f", s.ramp[i]);
+        std::printf(" | indices");
+        for (const Deviation& d : s.deviations)
+            std::printf(" %d%sv%d:%+d", d.total, d.soft ? "s" : "", d.upcard, d.index);
+        std::printf("\n");
+    }
+};
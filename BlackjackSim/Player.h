@@ -23,6 +23,7 @@ private:
     bool canSplit = false;
     bool turnOver = false;
     bool busted = false;
+    bool verbose = true;
     float bal = 50;
     float bet = 0;
     int handTotal = 0;
@@ -40,6 +41,9 @@ public:
         canDouble = true;
         canSplit = false;
         bal = 50;
+        // Room for any hand a round can realistically deal, so dealing never has to grow them
+        hand.reserve(12);
+        handCopy.reserve(12);
     }
     // Getters
     bool getCanHit() const { return canHit; }
@@ -55,6 +59,7 @@ public:
     int getDrawX() const { return drawX; }
     int getDrawY() const { return drawY; }
     bool getHasAce() const { return hasAce; }
+    bool getVerbose() const { return verbose; }
 
     // Setters
     void setCanHit(bool value) { canHit = value; }
@@ -67,6 +72,10 @@ public:
     void setDrawX(int x) { drawX = x; }
     void setDrawY(int y) { drawY = y; }
     void setHasAce(bool value) { hasAce = value; }
+    void setTurnOver(bool value) { turnOver = value; }
+    void setBusted(bool value) { busted = value; }
+    // Turn off console output for headless simulation
+    void setVerbose(bool value) { verbose = value; }
 
     void startHand(Deck& d)
     {
@@ -96,6 +105,18 @@ public:
 
         return total;
     }
+    // A hand is soft when an Ace is still being counted as 11
+    bool isSoft() const
+    {
+        int total = 0;
+        bool ace = false;
+        for (const Card& c : hand) {
+            total += c.getValue();
+            if (c.getRank() == Rank::Ace)
+                ace = true;
+        }
+        return ace && total + 10 <= 21;
+    }
     int getTotalCopy() const
     {
         int total = 0;
@@ -178,8 +199,8 @@ public:
     ********************************************************************************************/
     void doubleDown(Deck& d)
     {
+        bal -= bet;
         bet *= 2;
-        d.deal();
         hand.push_back(d.deal());
         handTotal += hand.back().getValue();
         turnOver = true;
@@ -192,15 +213,19 @@ public:
     {
         if (calculateHandTotal() >= 21)
         {
-            std::cout << "You can't hit right now!" << std::endl;
+            if (verbose)
+                std::cout << "You can't hit right now!" << std::endl;
             return;
         }
         hand.push_back(d.deal());
-        std::cout << "You hit and received a ";
-        hand.back().display();
         if (hand.back().getValue() == 1)
             hasAce = true;
-        std::cout << std::endl;
+        if (verbose)
+        {
+            std::cout << "You hit and received a ";
+            hand.back().display();
+            std::cout << std::endl;
+        }
         handTotal += hand.back().getValue();
     }
 
@@ -211,10 +236,12 @@ public:
     {
         if (!canStand)
         {
-            std::cout << "You can't stand right now!" << std::endl;
+            if (verbose)
+                std::cout << "You can't stand right now!" << std::endl;
             return;
         }
-        std::cout << "You stood!" << std::endl << std::endl;
+        if (verbose)
+            std::cout << "You stood!" << std::endl << std::endl;
         turnOver = true;
     }
 
@@ -223,7 +250,8 @@ public:
     ********************************************************************************************/
     void bust(void)
     {
-        std::cout << "You busted and lost!" << std::endl << std::endl;
+        if (verbose)
+            std::cout << "You busted and lost!" << std::endl << std::endl;
         busted = true;
         turnOver = true;
     }
@@ -233,6 +261,8 @@ public:
     ********************************************************************************************/
     void displayWinnings(float winnings)
     {
+        if (!verbose)
+            return;
         std::cout << "You won: " << winnings << std::endl;
         std::cout << "Your new balance: " << bal << std::endl << std::endl;
     }
@@ -260,7 +290,6 @@ bool Player::takeAction(Deck& d, int action)
         // if a 1 is passed in, it means hit
     case 1:
         hit(d);
-        drawHand(textures);
         break;
         // 2 means stand
     case 2:
@@ -268,7 +297,6 @@ bool Player::takeAction(Deck& d, int action)
         break;
     case 3:
         doubleDown(d);
-        drawHand(textures);
         break;
     case 4:
         surrender();
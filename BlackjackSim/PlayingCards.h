@@ -3,7 +3,8 @@
 * @brief Header file for playing cards and deck management in a Blackjack simulation.
 *
 * This file defines the `Card` class representing a playing card with its rank, suit, and texture,
-* and the `Deck` class which manages a collection of cards, allowing for shuffling and dealing.
+* and the `Deck` class which manages a collection of cards, allowing for shuffling and dealing,
+* either from a shoe that is dealt out or from a continuous shuffling machine.
 * It uses an external texture array (GLuint textures[]) filled by the texture loader.
 *
 * @author Michael Lintelman
@@ -14,6 +15,11 @@
 #include <vector>
 #include <algorithm>
 #include <random>
+#include "Random.h"
+#include "Profile.h"
+
+// The biggest shoe a Deck holds, eight decks
+const int MAX_SHOE_CARDS = 52 * 8;
 
 enum class Suit
 {
@@ -41,6 +47,7 @@ private:
     GLuint texture = 0;
 
 public:
+    Card() {}
     Card(Rank r, Suit s)
 		: rank(r), suit(s), texture(textures[cardIndex(r, s)]) // Use helper function to convert rank/suit to index for textures
     {
@@ -117,47 +124,277 @@ public:
     }
 };
 
-// Deck class to manage a collection of cards
+// Helper: the card for a 1..52 index (inverse of cardIndex)
+inline Card cardFromIndex(int index) {
+    return Card(static_cast<Rank>((index - 1) / 4), static_cast<Suit>((index - 1) % 4));
+}
+
+// Hi-Lo count tag: +1 for 2-6, 0 for 7-9, -1 for tens and aces
+inline int hiLoTag(const Card& c) {
+    int v = c.getValue();
+    return (v >= 2 && v <= 6) ? 1 : (v >= 7 && v <= 9) ? 0 : -1;
+}
+
+// Rank slot for composition counts: 0 is the Ace, 1..8 are two through nine, 9 is every ten-valued card
+const int RANK_SLOTS = 10;
+inline int rankSlot(const Card& c) {
+    return c.getValue() - 1;
+}
+
+// How a reproducible shoe sequence picks each shoe (see Deck::setShoeSequence)
+enum class ShoeSampling
+{
+    Independent,    // Every shoe is shuffled from its own seed
+    Antithetic,     // Odd shoes replay the shuffle of the shoe before with every random draw mirrored
+    Stratified,     // Shoe n starts with card n % 52, so each run of 52 shoes covers every first card once
+};
+
+/*******************************************************************************************
+* Fisher-Yates over `count` card types, taking up to four swap positions out of each random
+* number (see Xoshiro256::belowBatch). `mirrored` turns every draw j into i - 1 - j, which is
+* still a uniform shuffle but pulls in the opposite direction from the unmirrored one.
+********************************************************************************************/
+inline void shuffleCardTypes(Xoshiro256& rng, uint8_t* types, size_t count, bool mirrored) {
+    size_t i = count;
+    while (i > 1) {
+        uint64_t bounds[4], picks[4], product = 1;
+        int k = 0;
+        while (k < 4 && i - k > 1 && product * (i - k) < (1ull << 40)) {
+            bounds[k] = i - k;
+            product *= bounds[k];
+            k++;
+        }
+        rng.belowBatch(bounds, k, product, picks);
+        for (int d = 0; d < k; d++, i--)
+            std::swap(types[i - 1], types[mirrored ? i - 1 - picks[d] : picks[d]]);
+    }
+}
+
+/*******************************************************************************************
+* Shoe `n` of the sequence for `seed`: `decks` decks as card types (cardIndex() - 1) in dealing
+* order. `rng` is left where the shuffle finished, which is where a continuous shuffler carries
+* on from. Deck::startShoe() and ShoePipeline both shuffle through here, so shoe n is the same
+* whichever of them made it.
+********************************************************************************************/
+inline void shuffleShoe(uint64_t seed, uint64_t n, ShoeSampling sampling, int decks, uint8_t* types, Xoshiro256& rng) {
+    // Always shuffle from the same starting order so the seed alone decides the shoe
+    size_t count = 52 * static_cast<size_t>(decks);
+    for (size_t i = 0; i < count; i++)
+        types[i] = static_cast<uint8_t>(i / decks);
+    bool mirrored = sampling == ShoeSampling::Antithetic && (n & 1);
+    uint64_t key = sampling == ShoeSampling::Antithetic ? n >> 1 : n;
+    uint64_t mix = seed ^ (key * 0x9E3779B97F4A7C15ull);
+    rng.seed(splitMix64(mix));
+    size_t first = 0;
+    if (sampling == ShoeSampling::Stratified && count > 0) {
+        // Types are sorted, so this is the first copy of type n % 52
+        std::swap(types[0], types[(n % 52) * decks]);
+        first = 1;
+    }
+    shuffleCardTypes(rng, types + first, count - first, mirrored);
+}
+
+// Deck class to manage a shoe of cards. The shoe is shuffled once and dealt by moving a cursor
+// through it, so the cards never move while they are being dealt.
 class Deck
 {
 private:
-    int length = 0;
+    size_t next = 0;    // Index of the next card to deal
+    int runningCount = 0;
+    int dealtCounts[RANK_SLOTS] = {};   // Cards out of the shoe by rank slot
+    Xoshiro256 rng;
+
+    // Reproducible shoe sequence: shoe n is always the same shuffle of the same seed
+    bool sequenced = false;
+    uint64_t shoeSeed = 0;
+    uint64_t shoeNumber = 0;
+    ShoeSampling sampling = ShoeSampling::Independent;
+
+    // Continuous shuffling machine. Cards between next and next + staged have already dropped
+    // onto the delivery shelf and come out in that order; the rest of the undealt cards are the
+    // machine's pool. Cards before roundStart are discards from finished rounds still in the tray.
+    bool continuous = false;
+    size_t shelfSize = 10;
+    size_t batchSize = 10;
+    size_t staged = 0;
+    size_t roundStart = 0;
+    std::vector<uint8_t> order;     // Scratch for startShoe(), kept so reshuffling never allocates
+
+    // Fisher-Yates from `first` to the end; `mirrored` turns every draw j into i - 1 - j, which
+    // is still a uniform shuffle but pulls in the opposite direction from the unmirrored one
+    void shuffleFrom(size_t first, bool mirrored) {
+        for (size_t i = cards.size() - first; i > 1; i--) {
+            size_t j = rng.below(i);
+            std::swap(cards[first + i - 1], cards[first + (mirrored ? i - 1 - j : j)]);
+        }
+    }
+
+    // Pick the next shelf of cards at random from the pool, a partial Fisher-Yates in place
+    void loadShelf() {
+        BJ_PROFILE_SCOPE(Phase::Shuffle);
+        size_t pool = cards.size() - next;
+        if (pool == 0 && roundStart > 0) {
+            reinsertDiscards();
+            pool = cards.size() - next;
+        }
+        staged = std::min(shelfSize, pool);
+        for (size_t i = 0; i < staged; i++)
+            std::swap(cards[next + i], cards[next + i + rng.below(pool - i)]);
+    }
+
+    // Feed the discard tray back into the machine. The cards in play and the loaded shelf move
+    // to the front, which leaves the discards at the start of the pool.
+    void reinsertDiscards() {
+        BJ_PROFILE_SCOPE(Phase::Shuffle);
+        for (size_t i = 0; i < roundStart; i++) {
+            runningCount -= hiLoTag(cards[i]);
+            dealtCounts[rankSlot(cards[i])]--;
+        }
+        std::rotate(cards.begin(), cards.begin() + roundStart, cards.begin() + next + staged);
+        next -= roundStart;
+        roundStart = 0;
+    }
 
 public:
-    std::vector<Card> cards;
+    std::vector<Card> cards;    // The whole shoe in dealing order; cards[next] is dealt next
+
+    Deck()
+    {
+        std::random_device rd;
+        rng.seed((static_cast<uint64_t>(rd()) << 32) | rd());
+    }
+
+    // Cards left to deal
+    int getLength() const { return static_cast<int>(cards.size() - next); }
+    size_t getNext() const { return next; }
+    bool getContinuous() const { return continuous; }
+    size_t getStaged() const { return staged; }
+    size_t getRoundStart() const { return roundStart; }
+    int getRunningCount() const { return runningCount; }
+    const int* getDealtCounts() const { return dealtCounts; }
+    const Xoshiro256& getRng() const { return rng; }
 
-    int getLength() const { return length; }
-    // Display entire deck for debugging
+    // Move the cursor, e.g. when restoring a saved shoe
+    void setNext(size_t value) {
+        next = std::min(value, cards.size());
+        std::fill(dealtCounts, dealtCounts + RANK_SLOTS, 0);
+        for (size_t i = 0; i < next; i++)
+            dealtCounts[rankSlot(cards[i])]++;
+    }
+    void setStaged(size_t value) { staged = std::min(value, cards.size() - next); }
+    void setRoundStart(size_t value) { roundStart = std::min(value, next); }
+    void setRunningCount(int value) { runningCount = value; }
+    void setRng(const Xoshiro256& value) { rng = value; }
+    // Seed the shuffle so the same seed always produces the same shoe
+    void seed(uint64_t value) { rng.seed(value); }
+    // Display the cards left in the deck for debugging
     void display() const {
-        for (const auto& card : cards) {
-            card.display();
+        for (size_t i = next; i < cards.size(); i++) {
+            cards[i].display();
         }
     }
 
+    // Switch between a dealt-out shoe and a continuous shuffler that deals `shelf` cards at a time
+    // and takes the discards back once at least `batch` of them have piled up
+    void setContinuous(bool value, size_t shelf = 10, size_t batch = 10) {
+        continuous = value;
+        shelfSize = std::max<size_t>(shelf, 1);
+        batchSize = std::max<size_t>(batch, 1);
+        reset();
+    }
+
+    // Fisher-Yates over the undealt cards, with our own generator so a seed gives the same
+    // order on every platform. A loaded shelf stays as it is.
     void shuffle() {
-        std::random_device rd;
-        std::default_random_engine rng(rd());
-        std::shuffle(cards.begin(), cards.end(), rng);
+        shuffleFrom(next + staged, false);
     }
 
-    Card deal() {
-        Card retCard = cards.back();
-        cards.pop_back();
-        length--;
+    // Every later reset() deals shoe 0, 1, 2... of the sequence for `seed`, so two runs with the
+    // same seed see the same cards shoe by shoe however many rounds each one plays
+    void setShoeSequence(uint64_t seed, ShoeSampling mode) {
+        sequenced = true;
+        shoeSeed = seed;
+        shoeNumber = 0;
+        sampling = mode;
+    }
+    uint64_t getShoeNumber() const { return shoeNumber; }
+
+    // Gather every card back and shuffle shoe `n` of the sequence
+    void startShoe(uint64_t n) {
+        BJ_PROFILE_SCOPE(Phase::Shuffle);
+        int decks = std::max(1, static_cast<int>(cards.size() / 52));
+        order.resize(52 * static_cast<size_t>(decks));
+        Xoshiro256 after;
+        shuffleShoe(shoeSeed, n, sampling, decks, order.data(), after);
+        loadShoe(n, order.data(), order.size(), after);
+    }
+
+    // Deal shoe `n` from an order shuffled somewhere else (card types, see shuffleShoe), with the
+    // generator where that shuffle left it
+    void loadShoe(uint64_t n, const uint8_t* types, size_t count, const Xoshiro256& after) {
+        runningCount = 0;
+        std::fill(dealtCounts, dealtCounts + RANK_SLOTS, 0);
+        next = 0;
+        staged = 0;
+        roundStart = 0;
+        shoeNumber = n + 1;
+        cards.resize(count);
+        for (size_t i = 0; i < count; i++)
+            cards[i] = cardFromIndex(types[i] + 1);
+        rng = after;
+    }
+
+    const Card& deal() {
+        if (continuous) {
+            if (staged == 0)
+                loadShelf();
+            staged--;
+        } else if (next == cards.size()) {
+            // Only a shoe loaded by loadState() can run dry in the middle of a round; deal from a
+            // fresh one rather than past the end
+            reset();
+        }
+        const Card& retCard = cards[next++];
+        runningCount += hiLoTag(retCard);
+        dealtCounts[rankSlot(retCard)]++;
         return retCard;
     }
-	// Reset the deck to its initial state and shuffle
+    // The cards of the round just played go to the discards. A continuous shuffler takes them
+    // back in batches; a normal shoe keeps them out until the next reset.
+    void endRound() {
+        if (!continuous)
+            return;
+        roundStart = next;
+        if (roundStart >= batchSize)
+            reinsertDiscards();
+    }
+	// Gather every card back into the shoe and shuffle it in place
     void reset() {
-        cards.clear();
-        populate();
+        if (sequenced) {
+            startShoe(shoeNumber);
+            return;
+        }
+        BJ_PROFILE_SCOPE(Phase::Shuffle);
+        runningCount = 0;
+        std::fill(dealtCounts, dealtCounts + RANK_SLOTS, 0);
+        next = 0;
+        staged = 0;
+        roundStart = 0;
         shuffle();
+    }
+	// Replace the shoe with `decks` fresh decks, 1 to 8 (what a GameState holds), and shuffle it
+    void build(int decks) {
+        cards.clear();
+        decks = std::max(1, std::min(decks, MAX_SHOE_CARDS / 52));
+        for (int i = 0; i < decks; i++)
+            populate();
+        reset();
     }
 	// Populate the deck with 52 playing cards
     void populate() {
         for (int rank = 0; rank < 13; ++rank) {
             for (int suit = 0; suit < 4; ++suit) {
                 cards.emplace_back(static_cast<Rank>(rank), static_cast<Suit>(suit));
-                length++;
             }
         }
     }
@@ -0,0 +1,257 @@
+/*
+* @file Profile.h
+* @brief Scoped per-phase timers for the round hot path, compiled in only with BJ_PROFILE.
+*
+* BJ_PROFILE_SCOPE(Phase::X) times the rest of the enclosing block. Without BJ_PROFILE defined
+* the macro expands to nothing and none of the profiler exists, so a normal build pays nothing.
+* With it, each thread keeps its own `PhaseProfile`: a call count, a log2 histogram of ticks per
+* phase, and the self time of every nesting path (round;deal;shuffle, ...). The profiles are only
+* ever touched by their own thread and are merged when the report is printed at the end of a run.
+* Ticks are the time stamp counter on x86 and steady_clock nanoseconds elsewhere.
+*
+* writeFolded() writes the paths in the folded stack format that flamegraph.pl and speedscope
+* read, one "round;deal;shuffle <ticks>" line per path.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <cstdint>
+
+enum class Phase : uint8_t
+{
+    Round, Shuffle, Deal, Decision, DealerTurn, Settle
+};
+const int PHASE_COUNT = 6;
+
+inline const char* phaseName(Phase p)
+{
+    static const char* const names[PHASE_COUNT] = { "round", "shuffle", "deal", "decision", "dealer_turn", "settle" };
+    return names[static_cast<int>(p)];
+}
+
+#ifdef BJ_PROFILE
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+inline uint64_t profileTicks()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// One thread's timings; only its own thread writes to it
+class PhaseProfile
+{
+public:
+    static const int BUCKETS = 48;      // Bucket b holds durations in [2^(b-1), 2^b) ticks
+    static const int MAX_DEPTH = 8;
+
+private:
+    struct Frame
+    {
+        uint64_t start;
+        uint64_t children;      // Ticks spent in nested phases
+    };
+    Frame stack[MAX_DEPTH];
+    int depth = 0;
+    uint32_t path = 0;          // The open phases, 3 bits each, phase + 1 so that 0 ends the path
+
+public:
+    uint64_t counts[PHASE_COUNT] = {};
+    uint64_t ticks[PHASE_COUNT] = {};
+    uint64_t histogram[PHASE_COUNT][BUCKETS] = {};
+    std::unordered_map<uint32_t, uint64_t> selfTicks;      // By path
+
+    void enter(Phase p)
+    {
+        if (depth < MAX_DEPTH)
+            stack[depth] = Frame{ profileTicks(), 0 };
+        depth++;
+        path = (path << 3) | (static_cast<uint32_t>(p) + 1);
+    }
+
+    void leave(Phase p)
+    {
+        uint64_t now = profileTicks();
+        depth--;
+        if (depth < MAX_DEPTH)
+        {
+            uint64_t elapsed = now - stack[depth].start;
+            int i = static_cast<int>(p);
+            counts[i]++;
+            ticks[i] += elapsed;
+            int bucket = 0;
+            for (uint64_t t = elapsed; t > 0 && bucket < BUCKETS - 1; t >>= 1)
+                bucket++;
+            histogram[i][bucket]++;
+            selfTicks[path] += elapsed - std::min(elapsed, stack[depth].children);
+            if (depth > 0 && depth <= MAX_DEPTH)
+                stack[depth - 1].children += elapsed;
+        }
+        path >>= 3;
+    }
+
+    void merge(const PhaseProfile& o)
+    {
+        for (int i = 0; i < PHASE_COUNT; i++)
+        {
+            counts[i] += o.counts[i];
+            ticks[i] += o.ticks[i];
+            for (int b = 0; b < BUCKETS; b++)
+                histogram[i][b] += o.histogram[i][b];
+        }
+        for (const auto& entry : o.selfTicks)
+            selfTicks[entry.first] += entry.second;
+    }
+
+    // Upper edge, in ticks, of the bucket holding the given percentile (0-100)
+    uint64_t percentile(int phase, double p) const
+    {
+        uint64_t target = static_cast<uint64_t>(p / 100.0 * counts[phase]);
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++)
+        {
+            seen += histogram[phase][b];
+            if (seen > target)
+                return b == 0 ? 0 : (1ull << b) - 1;
+        }
+        return 0;
+    }
+};
+
+// Owns every thread's profile so they outlive their threads, and merges them for the report
+class Profiler
+{
+private:
+    std::mutex lock;
+    std::vector<std::unique_ptr<PhaseProfile>> profiles;
+
+public:
+    static Profiler& instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    // The calling thread's profile, registered the first time the thread asks
+    static PhaseProfile& local()
+    {
+        thread_local PhaseProfile* profile = nullptr;
+        if (!profile)
+        {
+            Profiler& p = instance();
+            std::lock_guard<std::mutex> guard(p.lock);
+            p.profiles.emplace_back(new PhaseProfile());
+            profile = p.profiles.back().get();
+        }
+        return *profile;
+    }
+
+    // Only call once the threads being profiled have finished
+    PhaseProfile merged()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        PhaseProfile total;
+        for (const auto& p : profiles)
+            total.merge(*p);
+        return total;
+    }
+
+    // Ticks per microsecond, measured against steady_clock over a few milliseconds
+    static double ticksPerUs()
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint64_t first = profileTicks();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20))
+            ;
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        return (profileTicks() - first) / us;
+    }
+
+    void print()
+    {
+        PhaseProfile total = merged();
+        double perUs = ticksPerUs();
+        std::printf("%-12s %12s %12s %10s %10s %10s\n", "Phase", "Calls", "Total ms", "Mean ns", "p50 ns", "p99 ns");
+        for (int i = 0; i < PHASE_COUNT; i++)
+        {
+            if (total.counts[i] == 0)
+                continue;
+            double mean = static_cast<double>(total.ticks[i]) / total.counts[i];
+            std::printf("%-12s %12llu %12.1f %10.1f %10.0f %10.0f\n", phaseName(static_cast<Phase>(i)),
+                static_cast<unsigned long long>(total.counts[i]), total.ticks[i] / perUs / 1000.0,
+                mean * 1000.0 / perUs, total.percentile(i, 50) * 1000.0 / perUs, total.percentile(i, 99) * 1000.0 / perUs);
+        }
+    }
+
+    bool writeFolded(const char* path)
+    {
+        PhaseProfile total = merged();
+        FILE* file = std::fopen(path, "w");
+        if (!file)
+            return false;
+        for (const auto& entry : total.selfTicks)
+        {
+            // The path was built most recent phase last, so read the digits from the top
+            uint32_t digits[PhaseProfile::MAX_DEPTH + 2];
+            int n = 0;
+            for (uint32_t p = entry.first; p != 0 && n < PhaseProfile::MAX_DEPTH + 2; p >>= 3)
+                digits[n++] = p & 7;
+            for (int i = n - 1; i >= 0; i--)
+                std::fprintf(file, i == n - 1 ? "%s" : ";%s", phaseName(static_cast<Phase>(digits[i] - 1)));
+            std::fprintf(file, " %llu\n", static_cast<unsigned long long>(entry.second));
+        }
+        return std::fclose(file) == 0;
+    }
+};
+
+// Times the rest of the enclosing scope as `phase`
+class ScopedPhase
+{
+private:
+    PhaseProfile& profile;
+    Phase phase;
+
+public:
+    explicit ScopedPhase(Phase p)
+        : profile(Profiler::local()), phase(p)
+    {
+        profile.enter(phase);
+    }
+    ~ScopedPhase() { profile.leave(phase); }
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+};
+
+// Print the merged phase table and write the folded stacks next to it
+inline void reportProfile(const char* foldedPath)
+{
+    Profiler::instance().print();
+    if (Profiler::instance().writeFolded(foldedPath))
+        std::printf("Folded stacks written to %s\n", foldedPath);
+}
+
+#define BJ_PROFILE_CONCAT2(a, b) a##b
+#define BJ_PROFILE_CONCAT(a, b) BJ_PROFILE_CONCAT2(a, b)
+#define BJ_PROFILE_SCOPE(phase) ScopedPhase BJ_PROFILE_CONCAT(profileScope, __LINE__)(phase)
+#else
+#define BJ_PROFILE_SCOPE(phase) ((void)0)
+
+inline void reportProfile(const char*) {}
+#endif
@@ -0,0 +1,119 @@
+/*
+* @file Random.h
+* @brief Small, fast random number generator with a plain-data state.
+*
+* This file defines `Xoshiro256`, an implementation of xoshiro256** seeded through splitmix64.
+* Its whole state is four 64-bit words, so it can be copied into a saved game and restored
+* with the same bytes on every platform. It satisfies UniformRandomBitGenerator, and below()
+* gives unbiased integers without going through the standard distributions, whose output is
+* implementation-defined. belowBatch() takes several of them out of a single draw.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <cstdint>
+#include <limits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// High 64 bits of a 64x64-bit multiply
+inline uint64_t mulHigh64(uint64_t a, uint64_t b)
+{
+#ifdef _MSC_VER
+    return __umulh(a, b);
+#else
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#endif
+}
+
+// Mixes a 64-bit value; used to expand one seed into a full generator state
+inline uint64_t splitMix64(uint64_t& x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+struct Xoshiro256
+{
+    uint64_t s[4];
+
+    using result_type = uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+
+    void seed(uint64_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            s[i] = splitMix64(value);
+    }
+
+    result_type operator()()
+    {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, n) using Lemire's multiply-and-reject method
+    uint64_t below(uint64_t n)
+    {
+        uint64_t x = (*this)();
+        uint64_t low = x * n;
+        if (low < n)
+        {
+            uint64_t threshold = (0 - n) % n;
+            while (low < threshold)
+            {
+                x = (*this)();
+                low = x * n;
+            }
+        }
+        return mulHigh64(x, n);
+    }
+
+    /*******************************************************************************************
+    * Unbiased integers out[i] in [0, bounds[i]) for i < k from one 64-bit draw, after
+    * Brackett-Rozinsky and Lemire's batched ranged random integers: each bound multiplies the
+    * low word left by the one before. `product` is the product of the bounds and must fit in
+    * 64 bits; the smaller it is, the less often a draw has to be thrown away.
+    ********************************************************************************************/
+    void belowBatch(const uint64_t* bounds, int k, uint64_t product, uint64_t* out)
+    {
+        uint64_t low = (*this)();
+        for (int i = 0; i < k; i++)
+        {
+            out[i] = mulHigh64(low, bounds[i]);
+            low *= bounds[i];
+        }
+        if (low < product)
+        {
+            uint64_t threshold = (0 - product) % product;
+            while (low < threshold)
+            {
+                low = (*this)();
+                for (int i = 0; i < k; i++)
+                {
+                    out[i] = mulHigh64(low, bounds[i]);
+                    low *= bounds[i];
+                }
+            }
+        }
+    }
+
+    // Uniform double in [0, 1)
+    double uniform() { return ((*this)() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
@@ -0,0 +1,335 @@
+/*
+* @file Replay.h
+* @brief Plays fixed seeds through the engine and checks every round against a golden file.
+*
+* This file defines `ReplayRun`, the digests of every round of a fixed set of scenarios, and the
+* functions that record one, save and load it, and compare a fresh run with a saved one. Each
+* scenario is a seed and a set of rules played by a Simulator on its shoe sequence, so the same
+* engine deals the same rounds on every run and every platform.
+*
+* A round's digest hashes its cards, the first action, the bet, insurance and what was paid.
+* Every later action draws a card or ends the turn, so between them they pin down the round. The
+* file keeps the running hash up to each round rather than the round's own, so the runs agree up
+* to some round and differ from it on, and the first diverging round is found by bisection. The
+* same file is a throughput check: the engine is timed apart from the digests, over several runs,
+* against a fixed calibration workload so that the machine's own speed drops out.
+*
+* File layout, all integers little-endian:
+*
+*   "BJRPL2\n\0"                                8-byte magic
+*   uint32 scenario count
+*   uint64 rounds per scenario
+*   float64 hands per second when recorded
+*   float64 hands per second of calibration work when recorded
+*   per scenario: uint64 seed, then rounds * uint64 running digests
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+const char REPLAY_MAGIC[8] = { 'B', 'J', 'R', 'P', 'L', '2', '\n', '\0' };
+
+struct ReplayScenario
+{
+    const char* name;
+    uint64_t seed;
+    int decks;
+    bool hitSoft17;
+    bool peeks;
+    bool continuous;    // Deal from the continuous shuffler
+    bool indices;       // Hi-Lo bet ramp and the Illustrious 18 instead of flat basic strategy
+};
+
+// Between them they cover every rule and both players; changing this list invalidates golden files
+inline const std::vector<ReplayScenario>& replayScenarios()
+{
+    static const std::vector<ReplayScenario> scenarios = {
+        { "1 deck S17 basic", 0x5EED0001, 1, false, true, false, false },
+        { "6 decks H17 indices", 0x5EED0002, 6, true, true, false, true },
+        { "8 decks ENHC basic", 0x5EED0003, 8, false, false, false, false },
+        { "6 decks CSM indices", 0x5EED0004, 6, true, true, true, true },
+    };
+    return scenarios;
+}
+
+inline uint64_t digestMix(uint64_t h, uint64_t v)
+{
+    // splitmix64's finalizer over the hash and the value
+    uint64_t z = h ^ (v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2));
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Money in half units, which every bet and payout in the game is a whole number of
+inline uint64_t digestAmount(float amount)
+{
+    return static_cast<uint64_t>(static_cast<int64_t>(amount * 2.0f));
+}
+
+inline uint64_t roundDigest(const TableSnapshot& s, const HandRecord& r)
+{
+    uint64_t h = digestMix(0, s.playerCount * 16 + s.dealerCount);
+    for (int i = 0; i < s.playerCount; i++)
+        h = digestMix(h, cardIndex(s.playerCards[i].getRank(), s.playerCards[i].getSuit()));
+    for (int i = 0; i < s.dealerCount; i++)
+        h = digestMix(h, cardIndex(s.dealerCards[i].getRank(), s.dealerCards[i].getSuit()));
+    h = digestMix(h, static_cast<uint64_t>(r.firstAction) * 8 + static_cast<uint64_t>(r.result));
+    h = digestMix(h, digestAmount(r.bet));
+    h = digestMix(h, digestAmount(s.insurance));
+    return digestMix(h, digestAmount(r.net));
+}
+
+/*******************************************************************************************
+* Play `rounds` rounds of a scenario from its first shoe, calling `onRound` after each one with
+* the settled table and the round's record
+********************************************************************************************/
+inline SimResult playScenario(const ReplayScenario& scenario, uint64_t rounds,
+    std::function<void(const TableSnapshot&, const HandRecord&)> onRound)
+{
+    Rules rules;
+    rules.decks = scenario.decks;
+    rules.dealerHitsSoft17 = scenario.hitSoft17;
+    rules.dealerPeeks = scenario.peeks;
+    CountStrategy indices;
+    const float ramp[BET_RAMP_SIZE] = { 1, 1, 2, 4, 6, 8 };
+    std::copy(ramp, ramp + BET_RAMP_SIZE, indices.ramp);
+    indices.deviations = illustriousDeviations();
+
+    Simulator sim;
+    sim.setRules(rules);
+    sim.getDeck().setShoeSequence(scenario.seed, ShoeSampling::Independent);
+    sim.getDeck().setContinuous(scenario.continuous);
+    sim.setStrategy(scenario.indices ? &indices : nullptr);
+    Table& table = sim.getTable();
+    if (onRound)
+        sim.setRecorder([&table, &onRound](const HandRecord& r) { onRound(table.getSnapshot(), r); });
+    return sim.run(rounds);
+}
+
+// Timed runs of each scenario; the middle one counts
+const int REPLAY_TIMING_RUNS = 7;
+
+// A fixed workload that shares no code with the engine: random reads over a few megabytes and a
+// sort of a small array. Contention for the caches from other work on the machine is what moves
+// the engine's speed most, and this feels it the same way.
+inline double calibrationSeconds()
+{
+    static std::vector<uint32_t> table(1 << 20);
+    static std::vector<uint32_t> values(1 << 14);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t h = 1, sum = 0;
+    for (int i = 0; i < (1 << 21); i++)
+    {
+        h = digestMix(h, i);
+        sum += table[h & (table.size() - 1)]++;
+    }
+    for (int pass = 0; pass < 8; pass++)
+    {
+        for (uint32_t& v : values)
+            v = static_cast<uint32_t>(h = digestMix(h, pass));
+        std::sort(values.begin(), values.end());
+    }
+    volatile uint64_t sink = sum + values[values.size() / 2];
+    (void)sink;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*******************************************************************************************
+* Throughput of every scenario played for `rounds` rounds with nothing recorded. Each of
+* REPLAY_TIMING_RUNS runs of a scenario is timed right after the calibration workload, and
+* the median of the two times' ratios is kept, so a machine that is busier or clocked lower
+* than usual for a while slows both and cancels out. `handsPerSecond` is the fastest plain
+* rate, for the record; the return value is hands per second of calibration work, which is
+* what the regression check compares.
+********************************************************************************************/
+inline double replayThroughput(uint64_t rounds, double& handsPerSecond)
+{
+    double engine = 0, fastest = 0;
+    for (const ReplayScenario& scenario : replayScenarios())
+    {
+        double ratios[REPLAY_TIMING_RUNS];
+        double best = 0;
+        for (int run = 0; run < REPLAY_TIMING_RUNS; run++)
+        {
+            double calibration = calibrationSeconds();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            playScenario(scenario, rounds, nullptr);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            ratios[run] = seconds / calibration;
+            best = run == 0 ? seconds : std::min(best, seconds);
+        }
+        std::nth_element(ratios, ratios + REPLAY_TIMING_RUNS / 2, ratios + REPLAY_TIMING_RUNS);
+        engine += ratios[REPLAY_TIMING_RUNS / 2];
+        fastest += best;
+    }
+    uint64_t hands = rounds * replayScenarios().size();
+    handsPerSecond = fastest > 0 ? hands / fastest : 0.0;
+    return engine > 0 ? hands / engine : 0.0;
+}
+
+struct ReplayRun
+{
+    uint64_t rounds = 0;
+    double handsPerSecond = 0;
+    double handsPerCalibration = 0;     // Hands per second of calibration work, see replayThroughput()
+    std::vector<uint64_t> seeds;
+    std::vector<std::vector<uint64_t>> digests;    // Per scenario, the running digest after each round
+};
+
+// Play every scenario for `rounds` rounds collecting the digests, then time them with replayThroughput()
+inline ReplayRun recordReplay(uint64_t rounds)
+{
+    ReplayRun run;
+    run.rounds = rounds;
+    for (const ReplayScenario& scenario : replayScenarios())
+    {
+        std::vector<uint64_t> digests;
+        digests.reserve(rounds);
+        uint64_t h = scenario.seed;
+        playScenario(scenario, rounds, [&](const TableSnapshot& s, const HandRecord& r) {
+            h = digestMix(h, roundDigest(s, r));
+            digests.push_back(h);
+        });
+        run.seeds.push_back(scenario.seed);
+        run.digests.push_back(std::move(digests));
+    }
+    run.handsPerCalibration = replayThroughput(rounds, run.handsPerSecond);
+    return run;
+}
+
+inline bool saveReplay(const char* path, const ReplayRun& run)
+{
+    FILE* f = std::fopen(path, "wb");
+    if (!f)
+        return false;
+    uint32_t scenarios = static_cast<uint32_t>(run.digests.size());
+    bool ok = std::fwrite(REPLAY_MAGIC, sizeof(REPLAY_MAGIC), 1, f) == 1
+        && std::fwrite(&scenarios, sizeof(scenarios), 1, f) == 1
+        && std::fwrite(&run.rounds, sizeof(run.rounds), 1, f) == 1
+        && std::fwrite(&run.handsPerSecond, sizeof(run.handsPerSecond), 1, f) == 1
+        && std::fwrite(&run.handsPerCalibration, sizeof(run.handsPerCalibration), 1, f) == 1;
+    for (uint32_t i = 0; ok && i < scenarios; i++)
+        ok = std::fwrite(&run.seeds[i], sizeof(uint64_t), 1, f) == 1
+            && std::fwrite(run.digests[i].data(), sizeof(uint64_t), run.digests[i].size(), f) == run.digests[i].size();
+    return std::fclose(f) == 0 && ok;
+}
+
+inline bool loadReplay(const char* path, ReplayRun& run)
+{
+    FILE* f = std::fopen(path, "rb");
+    if (!f)
+        return false;
+    char magic[sizeof(REPLAY_MAGIC)];
+    uint32_t scenarios = 0;
+    bool ok = std::fread(magic, sizeof(magic), 1, f) == 1 && std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) == 0
+        && std::fread(&scenarios, sizeof(scenarios), 1, f) == 1
+        && std::fread(&run.rounds, sizeof(run.rounds), 1, f) == 1
+        && std::fread(&run.handsPerSecond, sizeof(run.handsPerSecond), 1, f) == 1
+        && std::fread(&run.handsPerCalibration, sizeof(run.handsPerCalibration), 1, f) == 1
+        && scenarios <= 64 && run.rounds <= (1ull << 28);
+    run.seeds.assign(ok ? scenarios : 0, 0);
+    run.digests.assign(ok ? scenarios : 0, std::vector<uint64_t>());
+    for (uint32_t i = 0; ok && i < scenarios; i++)
+    {
+        run.digests[i].resize(run.rounds);
+        ok = std::fread(&run.seeds[i], sizeof(uint64_t), 1, f) == 1
+            && std::fread(run.digests[i].data(), sizeof(uint64_t), run.rounds, f) == run.rounds;
+    }
+    std::fclose(f);
+    return ok;
+}
+
+// Index of the first round where the running digests differ, or the length of the shorter run if none does
+inline uint64_t firstDivergence(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b)
+{
+    uint64_t lo = 0, hi = std::min(a.size(), b.size());
+    // Once a round differs every running digest after it does too
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (a[mid] == b[mid])
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+inline void printReplayCard(const Card& c)
+{
+    static const char ranks[] = "A23456789TJQK";
+    static const char suits[] = "hdcs";
+    std::printf(" %c%c", ranks[static_cast<int>(c.getRank())], suits[static_cast<int>(c.getSuit())]);
+}
+
+// Replay a scenario up to round `round` (counting from 0) and print it
+inline void printReplayRound(const ReplayScenario& scenario, uint64_t round)
+{
+    static const char* const actions[] = { "None", "Hit", "Stand", "Double", "Surrender" };
+    static const char* const results[] = { "None", "Blackjack", "Win", "Loss", "Push", "Surrender" };
+    uint64_t played = 0;
+    playScenario(scenario, round + 1, [&](const TableSnapshot& s, const HandRecord& r) {
+        if (played++ != round)
+            return;
+        std::printf("  Player:");
+        for (int i = 0; i < s.playerCount; i++)
+            printReplayCard(s.playerCards[i]);
+        std::printf("  Dealer:");
+        for (int i = 0; i < s.dealerCount; i++)
+            printReplayCard(s.dealerCards[i]);
+        std::printf("\n  First action: %s  Bet: %.1f  Insurance: %.1f  Result: %s  Net: %+.1f\n",
+            actions[static_cast<int>(r.firstAction)], r.bet, s.insurance, results[static_cast<int>(r.result)], r.net);
+    });
+}
+
+/*******************************************************************************************
+* Compare a fresh run with a golden one and print the first diverging round of each scenario.
+* Passes when every digest matches and the hands per second are no more than `slowdown`
+* (a share, 0.1 for 10%) below the golden run's.
+********************************************************************************************/
+inline bool checkReplay(const ReplayRun& golden, const ReplayRun& current, double slowdown)
+{
+    const std::vector<ReplayScenario>& scenarios = replayScenarios();
+    bool ok = golden.digests.size() == scenarios.size() && golden.rounds == current.rounds;
+    if (!ok)
+        std::printf("The golden file has %zu scenarios of %llu rounds; this build plays %zu of %llu\n",
+            golden.digests.size(), static_cast<unsigned long long>(golden.rounds), scenarios.size(),
+            static_cast<unsigned long long>(current.rounds));
+    for (size_t i = 0; ok && i < scenarios.size(); i++)
+    {
+        if (golden.seeds[i] != scenarios[i].seed)
+        {
+            std::printf("%s: recorded with seed %llx, this build uses %llx\n", scenarios[i].name,
+                static_cast<unsigned long long>(golden.seeds[i]), static_cast<unsigned long long>(scenarios[i].seed));
+            ok = false;
+            continue;
+        }
+        uint64_t round = firstDivergence(golden.digests[i], current.digests[i]);
+        if (round == golden.rounds)
+        {
+            std::printf("%s: all %llu rounds match\n", scenarios[i].name, static_cast<unsigned long long>(golden.rounds));
+            continue;
+        }
+        std::printf("%s: first diverging round %llu of %llu, which now plays as\n", scenarios[i].name,
+            static_cast<unsigned long long>(round + 1), static_cast<unsigned long long>(golden.rounds));
+        printReplayRound(scenarios[i], round);
+        ok = false;
+    }
+
+    double change = golden.handsPerCalibration > 0
+        ? current.handsPerCalibration / golden.handsPerCalibration - 1.0 : 0.0;
+    bool fastEnough = change >= -slowdown;
+    std::printf("%.0f hands/s, golden %.0f; against the calibration %+.1f%% (allowed -%.1f%%)%s\n",
+        current.handsPerSecond, golden.handsPerSecond, change * 100.0, slowdown * 100.0, fastEnough ? "" : ": too slow");
+    return ok && fastEnough;
+}
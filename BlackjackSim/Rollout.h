@@ -0,0 +1,135 @@
+/*
+* @file Rollout.h
+* @brief What-if analysis: estimate the EV of each action from a saved decision point.
+*
+* This file defines the `RolloutAnalyzer` class. Given a `GameState` saved during the player's
+* turn, it restores the state thousands of times, reshuffles everything the player can't see
+* (the shoe and the dealer's hole card), takes one action and plays the rest of the round with
+* basic strategy. Every action replays the same reshuffles, so the differences between actions
+* are not swamped by card luck.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+struct ActionEstimate
+{
+    Action action = Action::Stand;
+    uint64_t samples = 0;
+    double mean = 0;    // EV per unit of the original bet
+    double m2 = 0;      // Sum of squared deviations (Welford)
+
+    void add(double x)
+    {
+        samples++;
+        double delta = x - mean;
+        mean += delta / samples;
+        m2 += delta * (x - mean);
+    }
+
+    double getStdErr() const { return samples > 1 ? std::sqrt(m2 / (samples - 1) / samples) : 0.0; }
+};
+
+class RolloutAnalyzer
+{
+private:
+    Simulator sim;
+
+    static CommandType commandFor(Action a)
+    {
+        switch (a)
+        {
+        case Action::Hit: return CommandType::Hit;
+        case Action::DoubleDown: return CommandType::DoubleDown;
+        case Action::Surrender: return CommandType::Surrender;
+        default: return CommandType::Stand;
+        }
+    }
+
+    // Whether an up card and a hole card, as card indices, are an Ace and a ten
+    static bool makesNatural(uint8_t up, uint8_t hole)
+    {
+        int a = rankSlot(cardFromIndex(up)), b = rankSlot(cardFromIndex(hole));
+        return (a == 0 && b == 9) || (a == 9 && b == 0);
+    }
+
+public:
+    // Estimate every legal action from `from`, which must be saved during the player's turn
+    std::vector<ActionEstimate> estimate(const GameState& from, int rollouts, uint64_t seed)
+    {
+        std::vector<ActionEstimate> estimates;
+        // A decision point has both hands dealt, and the hole card among the cards already out
+        if (static_cast<RoundState>(from.state) != RoundState::PlayerTurn || from.bet <= 0
+            || from.playerCount < 2 || from.dealerCount < 2 || from.shoeNext < from.playerCount + from.dealerCount)
+            return estimates;
+
+        bool twoCards = from.playerCount == 2;
+        bool affordDouble = from.bal >= from.bet;
+        for (Action a : { Action::Hit, Action::Stand, Action::DoubleDown, Action::Surrender })
+        {
+            if ((a == Action::DoubleDown && !(twoCards && affordDouble)) || (a == Action::Surrender && !twoCards))
+                continue;
+            ActionEstimate e;
+            e.action = a;
+            estimates.push_back(e);
+        }
+
+        Table& table = sim.getTable();
+        Player& player = sim.getPlayer();
+        bool peeks = table.getRules().dealerPeeks;
+        const float stake = from.bal + from.bet;
+        GameState fork;
+        for (int i = 0; i < rollouts; i++)
+        {
+            // Hide what the player can't see: the hole card goes back to the last dealt slot and is
+            // reshuffled together with the undealt part of the shoe
+            fork = from;
+            fork.rng.seed(seed + i);
+            int first = fork.shoeNext - 1;
+            for (int j = fork.shoeRoundStart; j < fork.shoeNext; j++)
+            {
+                if (fork.shoe[j] == fork.dealerCards[1])
+                {
+                    std::swap(fork.shoe[j], fork.shoe[first]);
+                    break;
+                }
+            }
+            // Under a peek the player only gets to act when the hole card isn't a natural, so the
+            // new one is drawn from the cards that can't make one
+            int pick, tries = 0;
+            do
+                pick = first + static_cast<int>(fork.rng.below(fork.shoeCount - first));
+            while (peeks && makesNatural(fork.dealerCards[0], fork.shoe[pick]) && ++tries < 64);
+            std::swap(fork.shoe[first], fork.shoe[pick]);
+            for (int j = fork.shoeCount - first - 1; j > 1; j--)
+                std::swap(fork.shoe[first + j], fork.shoe[first + 1 + fork.rng.below(j)]);
+            fork.dealerCards[1] = fork.shoe[first];
+
+            for (ActionEstimate& e : estimates)
+            {
+                table.loadState(fork);
+                table.submit(commandFor(e.action));
+                table.update();
+                sim.finishRound();
+                e.add((player.getBal() - stake) / from.bet);
+            }
+        }
+        return estimates;
+    }
+};
+
+// Print the estimates for a saved decision, best action first
+inline void printEstimates(std::vector<ActionEstimate> estimates)
+{
+    static const char* const names[] = { "", "Hit", "Stand", "Double", "Surrender" };
+    std::sort(estimates.begin(), estimates.end(),
+        [](const ActionEstimate& a, const ActionEstimate& b) { return a.mean > b.mean; });
+    for (const ActionEstimate& e : estimates)
+        std::printf("%-10s EV %+.4f  (+/- %.4f, %llu rollouts)\n", names[static_cast<int>(e.action)], e.mean,
+            e.getStdErr(), static_cast<unsigned long long>(e.samples));
+}
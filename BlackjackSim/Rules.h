@@ -0,0 +1,28 @@
+/*
+* @file Rules.h
+* @brief Table rules shared by the game, the simulators and the exact calculator.
+*
+* This file defines the `Rules` struct. The defaults are the game as it has always been played:
+* one deck reshuffled at half, blackjack paying 3:2, double down and surrender on the first
+* two cards, and a 50 chip bankroll with a half-chip minimum bet. The dealer stands on all 17s
+* and peeks for blackjack under an Ace or a ten, and insurance is offered on an Ace.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+
+struct Rules
+{
+    int decks = 1;
+    float penetration = 0.5f;       // Share of the shoe dealt before it is reshuffled
+    float blackjackPays = 1.5f;
+    bool doubleAllowed = true;      // Double down on any first two cards
+    bool surrenderAllowed = true;   // Late surrender on the first two cards
+    bool dealerHitsSoft17 = false;  // H17; otherwise the dealer stands on soft 17 (S17)
+    bool dealerPeeks = true;        // US hole card; otherwise ENHC, where a dealer blackjack also takes doubles
+    bool insuranceOffered = true;   // Insurance, or even money on a blackjack, against an Ace
+    float startingBankroll = 50;
+    float minimumBet = 0.5f;        // Smallest chip; the game is over once the balance can't cover it
+};
@@ -0,0 +1,231 @@
+/*
+* @file Scheduler.h
+* @brief Work-stealing scheduler for splitting a range of simulation work over threads.
+*
+* This file defines `WorkStealingDeque`, the lock-free deque of Chase and Lev (in the C11
+* formulation of Le et al.), and `WorkStealingPool`, which runs a function over a range of
+* indices. Every worker starts with an even share of the range in its own deque. It splits the
+* share in half again and again, keeping the lower half and pushing the upper one, until the
+* piece is no bigger than the grain. It takes its own work from the bottom of its deque, newest
+* first, and when that runs dry it steals from the top of another worker's, which is where the
+* biggest pieces are. Rounds differ a lot in cost, so a worker that gets cheap shoes ends up
+* taking work from one that got expensive ones instead of waiting at the end.
+*
+* Each worker counts its own statistics on its own cache line; they are only read after the
+* workers have been joined, so no locks are needed to gather them.
+*
+* Given a NumaTopology with setTopology(), each worker pins itself to its processor before it
+* runs anything, so whatever it allocates lands on its own node, and it steals from workers on
+* its own node before it looks across. Steals that cross nodes are counted separately: they are
+* the work that moved between sockets.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Bounded single-owner deque of 64-bit tasks. push() and pop() are for the owner, steal() for anyone.
+class WorkStealingDeque
+{
+private:
+    alignas(64) std::atomic<int64_t> top{ 0 };
+    alignas(64) std::atomic<int64_t> bottom{ 0 };
+    alignas(64) std::vector<std::atomic<uint64_t>> buffer;
+    int64_t mask;
+
+public:
+    // `capacity` is rounded up to a power of two
+    explicit WorkStealingDeque(size_t capacity = 256)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        buffer = std::vector<std::atomic<uint64_t>>(size);
+        mask = static_cast<int64_t>(size) - 1;
+    }
+
+    // Returns false when the deque is full
+    bool push(uint64_t task)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t > mask)
+            return false;
+        buffer[b & mask].store(task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Newest task first
+    bool pop(uint64_t& task)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        task = buffer[b & mask].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // Last task: race the thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Oldest task first; fails if the deque is empty or another thread got there first
+    bool steal(uint64_t& task)
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return false;
+        task = buffer[t & mask].load(std::memory_order_relaxed);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+};
+
+struct alignas(64) WorkerStats
+{
+    int node = 0;
+    bool pinned = false;
+    uint64_t items = 0;         // Indices run
+    uint64_t tasks = 0;         // Pieces run
+    uint64_t splits = 0;
+    uint64_t steals = 0;
+    uint64_t remoteSteals = 0;     // Of those, from a worker on another node
+    uint64_t failedSteals = 0;
+};
+
+class WorkStealingPool
+{
+private:
+    int threadCount;
+    uint64_t grain;
+    std::vector<WorkerStats> stats;
+    NumaTopology topology;
+    bool placed = false;
+
+    // A piece of the range is packed into one task: begin in the high half, end in the low half
+    static uint64_t pack(uint64_t begin, uint64_t end) { return (begin << 32) | end; }
+    static uint64_t beginOf(uint64_t task) { return task >> 32; }
+    static uint64_t endOf(uint64_t task) { return task & 0xFFFFFFFFull; }
+
+public:
+    // `threads` of 0 uses every hardware thread; pieces are split down to `grainSize` indices
+    WorkStealingPool(int threads = 0, uint64_t grainSize = 1)
+        : threadCount(threads > 0 ? threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))),
+        grain(std::max<uint64_t>(grainSize, 1))
+    {
+    }
+
+    // Pin workers and prefer stealing on the same node from now on. The thread that calls run()
+    // is worker 0 and stays pinned afterwards.
+    void setTopology(const NumaTopology& t)
+    {
+        topology = t;
+        placed = true;
+    }
+
+    int getThreads() const { return threadCount; }
+    const std::vector<WorkerStats>& getStats() const { return stats; }
+
+    /*******************************************************************************************
+    * Call fn(worker, begin, end) over pieces that cover [0, count) exactly once, on
+    * getThreads() workers numbered from 0. Returns once every piece has run. `count` must fit
+    * in 32 bits.
+    ********************************************************************************************/
+    template<typename Fn>
+    void run(uint64_t count, Fn fn)
+    {
+        count = std::min<uint64_t>(count, 0xFFFFFFFFull);
+        int threads = static_cast<int>(std::max<uint64_t>(1, std::min<uint64_t>(threadCount, count)));
+        stats.assign(threads, WorkerStats());
+        std::vector<WorkStealingDeque> deques(threads);
+        std::vector<int> cpuOf(threads, 0), nodeOf(threads, 0);
+        for (int w = 0; placed && w < threads; w++)
+            topology.place(w, cpuOf[w], nodeOf[w]);
+        for (int w = 0; w < threads; w++)
+        {
+            uint64_t begin = count * w / threads, end = count * (w + 1) / threads;
+            if (begin < end)
+                deques[w].push(pack(begin, end));
+        }
+        std::atomic<uint64_t> remaining(count);
+
+        auto worker = [&](int me) {
+            WorkerStats& s = stats[me];
+            s.node = nodeOf[me];
+            s.pinned = placed && NumaTopology::pinCurrentThread(cpuOf[me]);
+            uint64_t seed = 0x9E3779B97F4A7C15ull * (me + 1);
+            while (remaining.load(std::memory_order_acquire) > 0)
+            {
+                uint64_t task;
+                bool found = deques[me].pop(task);
+                // Out of work: try every other worker once from a random start, own node first
+                int offset = 0;
+                if (!found)
+                {
+                    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+                    offset = static_cast<int>(seed % threads);
+                }
+                for (int remote = 0; !found && remote < 2; remote++)
+                {
+                    for (int i = 0; !found && i < threads; i++)
+                    {
+                        int victim = (offset + i) % threads;
+                        if (victim == me || (nodeOf[victim] != nodeOf[me]) != (remote == 1))
+                            continue;
+                        found = deques[victim].steal(task);
+                        if (!found)
+                            s.failedSteals++;
+                        else if (remote == 1)
+                            s.remoteSteals++;
+                    }
+                    if (found)
+                        s.steals++;
+                }
+                if (!found)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                uint64_t begin = beginOf(task), end = endOf(task);
+                // Leave the upper half where a thief can find it
+                while (end - begin > grain)
+                {
+                    uint64_t mid = begin + (end - begin) / 2;
+                    if (!deques[me].push(pack(mid, end)))
+                        break;
+                    end = mid;
+                    s.splits++;
+                }
+                fn(me, begin, end);
+                s.items += end - begin;
+                s.tasks++;
+                remaining.fetch_sub(end - begin, std::memory_order_acq_rel);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++)
+            pool.emplace_back(worker, t);
+        worker(0);
+        for (std::thread& t : pool)
+            t.join();
+    }
+};
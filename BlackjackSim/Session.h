@@ -0,0 +1,477 @@
+/*
+* @file Session.h
+* @brief Coroutine player sessions, each on its own table, multiplexed on a small thread pool.
+*
+* This file defines `Session`, one player at one table whose game is a C++20 coroutine, and
+* `SessionPool`, the threads that resume them. Wherever the table waits for input the session
+* co_awaits its next command from a `CommandSource`: a `BotSource` playing a strategy, a
+* `ScriptedSource` replaying a fixed list of commands, or a `HumanSource` fed by clicks. Bots and
+* scripts answer at once; a human source parks the session until post() hands it a command and
+* puts it back on the pool, so a waiting player costs a coroutine frame and no thread.
+*
+* A session gives its thread back after every round, so thousands of them take turns on a few
+* threads. Each one touches only its own table, so they share nothing but the run queue. After
+* every command it publishes a copy of the table for other threads to read, which is how the
+* window draws the session its clicks are posted to.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class SessionPool
+{
+private:
+    std::mutex queueLock;
+    std::condition_variable queueReady;
+    std::condition_variable allDone;
+    std::deque<std::coroutine_handle<>> queue;
+    std::vector<std::thread> threads;
+    uint64_t live = 0;          // Sessions started and not finished, guarded by queueLock
+    bool running = true;
+    std::atomic<uint64_t> resumes{ 0 };
+
+    void workerLoop()
+    {
+        while (true)
+        {
+            std::coroutine_handle<> h;
+            {
+                std::unique_lock<std::mutex> lock(queueLock);
+                queueReady.wait(lock, [this] { return !queue.empty() || !running; });
+                if (queue.empty())
+                    return;
+                h = queue.front();
+                queue.pop_front();
+            }
+            resumes.fetch_add(1, std::memory_order_relaxed);
+            h.resume();
+        }
+    }
+
+public:
+    explicit SessionPool(int threadCount)
+    {
+        for (int t = 0; t < std::max(threadCount, 1); t++)
+            threads.emplace_back(&SessionPool::workerLoop, this);
+    }
+
+    ~SessionPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            running = false;
+        }
+        queueReady.notify_all();
+        for (std::thread& t : threads)
+            t.join();
+    }
+
+    SessionPool(const SessionPool&) = delete;
+    SessionPool& operator=(const SessionPool&) = delete;
+
+    int getThreads() const { return static_cast<int>(threads.size()); }
+    uint64_t getResumes() const { return resumes.load(); }
+    uint64_t getLive()
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        return live;
+    }
+
+    // Queue a suspended session to be resumed on one of the threads
+    void schedule(std::coroutine_handle<> h)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            queue.push_back(h);
+        }
+        queueReady.notify_one();
+    }
+
+    // A session joins before it is first scheduled and leaves once its coroutine has finished
+    void join()
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        live++;
+    }
+    void leave()
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        if (--live == 0)
+            allDone.notify_all();
+    }
+
+    // Wait for every session that has joined to finish
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(queueLock);
+        allDone.wait(lock, [this] { return live == 0; });
+    }
+
+    // co_await pool.yield() puts the session at the back of the queue to let the others have a turn
+    auto yield()
+    {
+        struct Yield
+        {
+            SessionPool& pool;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { pool.schedule(h); }
+            void await_resume() const noexcept {}
+        };
+        return Yield{ *this };
+    }
+};
+
+// The coroutine behind a session. It starts suspended, and leaves the pool once it has finished.
+class SessionTask
+{
+public:
+    struct promise_type
+    {
+        SessionPool* pool = nullptr;
+
+        SessionTask get_return_object() { return SessionTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept
+        {
+            // Only once the frame is suspended can the owner destroy it, so leave from there
+            struct Leave
+            {
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> h) noexcept { h.promise().pool->leave(); }
+                void await_resume() const noexcept {}
+            };
+            return Leave{};
+        }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+public:
+    SessionTask() = default;
+    explicit SessionTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    SessionTask(SessionTask&& o) noexcept : handle(o.handle) { o.handle = nullptr; }
+    SessionTask& operator=(SessionTask&& o) noexcept
+    {
+        std::swap(handle, o.handle);
+        return *this;
+    }
+    ~SessionTask()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    std::coroutine_handle<promise_type> getHandle() const { return handle; }
+};
+
+enum class SourceReply
+{
+    Ready,      // The command is filled in
+    Wait,       // Nothing yet; park the session
+    Done        // The player has left the table
+};
+
+// Where a session's commands come from
+class CommandSource
+{
+public:
+    virtual ~CommandSource() = default;
+
+    // The command for the table as it stands, if there is one yet
+    virtual SourceReply next(const TableSnapshot& s, Command& c) = 0;
+
+    /*******************************************************************************************
+    * Called when next() said Wait, with the session about to suspend. Returns false if the
+    * session should go on after all (next() has an answer now); otherwise the source keeps `h`
+    * and schedules it on `pool` once next() has one.
+    ********************************************************************************************/
+    virtual bool park(std::coroutine_handle<>, SessionPool&, const TableSnapshot&) { return false; }
+};
+
+// Hi-Lo true count from the cards the player hasn't seen, which is all a player at the table knows
+inline double snapshotTrueCount(const TableSnapshot& s)
+{
+    int running = 0, left = 0;
+    for (int r = 0; r < RANK_SLOTS; r++)
+    {
+        // The whole shoe counts to zero, so the cards seen count to minus the unseen ones
+        int tag = (r >= 1 && r <= 5) ? 1 : (r == 0 || r == 9) ? -1 : 0;
+        running -= tag * s.unseen[r];
+        left += s.unseen[r];
+    }
+    return left > 0 ? running * 52.0 / left : 0.0;
+}
+
+// What a player using `strategy` (nullptr for flat bets and basic strategy) does at this point
+inline Command strategyCommand(const TableSnapshot& s, const CountStrategy* strategy, float unit)
+{
+    Command c;
+    switch (s.state)
+    {
+    case RoundState::Betting:
+        if (s.bet > 0)
+            c.type = CommandType::Deal;
+        else
+        {
+            c.type = CommandType::AddChip;
+            c.amount = std::min(strategy ? unit * strategy->betUnits(snapshotTrueCount(s)) : unit, s.bal);
+        }
+        break;
+    case RoundState::Insurance:
+        c.type = strategy && strategy->takeInsurance(snapshotTrueCount(s)) ? CommandType::Insurance
+            : CommandType::DeclineInsurance;
+        break;
+    default:
+    {
+        int upcard = s.dealerCards[0].getValue();
+        Action a = strategy
+            ? strategy->play(s.playerTotal, s.playerSoft, upcard, s.canDouble, s.canSurrender, snapshotTrueCount(s))
+            : basicStrategy(s.playerTotal, s.playerSoft, upcard, s.canDouble, s.canSurrender);
+        static const CommandType commands[] = { CommandType::Stand, CommandType::Hit, CommandType::Stand,
+            CommandType::DoubleDown, CommandType::Surrender };
+        c.type = commands[static_cast<int>(a)];
+        break;
+    }
+    }
+    return c;
+}
+
+class BotSource : public CommandSource
+{
+private:
+    const CountStrategy* strategy;
+    float unit;
+
+public:
+    explicit BotSource(const CountStrategy* play = nullptr, float betUnit = 1.0f) : strategy(play), unit(betUnit) {}
+
+    SourceReply next(const TableSnapshot& s, Command& c) override
+    {
+        c = strategyCommand(s, strategy, unit);
+        return SourceReply::Ready;
+    }
+};
+
+// Plays the commands in order, whatever the table shows; the table drops any that aren't legal
+class ScriptedSource : public CommandSource
+{
+private:
+    std::vector<Command> script;
+    size_t position = 0;
+
+public:
+    explicit ScriptedSource(std::vector<Command> commands) : script(std::move(commands)) {}
+
+    SourceReply next(const TableSnapshot&, Command& c) override
+    {
+        if (position == script.size())
+            return SourceReply::Done;
+        c = script[position++];
+        return SourceReply::Ready;
+    }
+};
+
+// Commands posted from another thread, such as the window's input callbacks
+class HumanSource : public CommandSource
+{
+private:
+    std::mutex lock;
+    std::deque<Command> clicks;
+    std::coroutine_handle<> waiter;
+    SessionPool* waiterPool = nullptr;
+    TableSnapshot waitingOn;
+    bool closed = false;
+
+public:
+    SourceReply next(const TableSnapshot&, Command& c) override
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!clicks.empty())
+        {
+            c = clicks.front();
+            clicks.pop_front();
+            return SourceReply::Ready;
+        }
+        return closed ? SourceReply::Done : SourceReply::Wait;
+    }
+
+    bool park(std::coroutine_handle<> h, SessionPool& pool, const TableSnapshot& s) override
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        // A click or close() can land between next() and here
+        if (!clicks.empty() || closed)
+            return false;
+        waiter = h;
+        waiterPool = &pool;
+        waitingOn = s;
+        return true;
+    }
+
+    void post(const Command& c)
+    {
+        std::coroutine_handle<> h;
+        SessionPool* pool = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            clicks.push_back(c);
+            std::swap(h, waiter);
+            pool = waiterPool;
+        }
+        // Schedule outside the lock, since the session may take it again as soon as it runs
+        if (h)
+            pool->schedule(h);
+    }
+
+    // The player leaves; the session finishes at its next decision
+    void close()
+    {
+        std::coroutine_handle<> h;
+        SessionPool* pool = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closed = true;
+            std::swap(h, waiter);
+            pool = waiterPool;
+        }
+        // Schedule outside the lock, since the session may take it again as soon as it runs
+        if (h)
+            pool->schedule(h);
+    }
+
+    // Whether the session is parked waiting for a click, and the table it is looking at
+    bool waiting(TableSnapshot& s)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!waiter)
+            return false;
+        s = waitingOn;
+        return true;
+    }
+};
+
+class Session
+{
+private:
+    Deck deck;
+    Player player;
+    Dealer dealer;
+    Table table;
+    CommandSource& source;
+    SessionPool& pool;
+    SimResult stats;
+    SessionTask task;
+    std::mutex viewLock;
+    TableSnapshot view;         // The table as of the last command, guarded by viewLock
+
+    void publish()
+    {
+        std::lock_guard<std::mutex> guard(viewLock);
+        view = table.getSnapshot();
+    }
+
+    // co_await yields true with the next command, or false once the source is done
+    struct NextCommand
+    {
+        Session& session;
+        Command& command;
+        SourceReply reply = SourceReply::Wait;
+
+        bool await_ready()
+        {
+            reply = session.source.next(session.table.getSnapshot(), command);
+            return reply != SourceReply::Wait;
+        }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            return session.source.park(h, session.pool, session.table.getSnapshot());
+        }
+        bool await_resume()
+        {
+            // Woken by the source, so this time it has an answer
+            if (reply == SourceReply::Wait)
+                reply = session.source.next(session.table.getSnapshot(), command);
+            return reply == SourceReply::Ready;
+        }
+    };
+
+    SessionTask play(uint64_t rounds)
+    {
+        float roundStart = table.getSnapshot().bal;
+        uint32_t settled = table.getSnapshot().round;
+        while (stats.rounds < rounds && !table.getGameOver())
+        {
+            Command c;
+            if (!co_await NextCommand{ *this, c })
+                break;
+            const TableSnapshot& before = table.getSnapshot();
+            if (c.type == CommandType::Deal && before.state == RoundState::Betting)
+                stats.wagered += before.bet;
+            table.submit(c.type, c.amount);
+            table.update();
+            publish();
+
+            const TableSnapshot& s = table.getSnapshot();
+            if (s.state != RoundState::Betting || s.round == settled)
+                continue;
+            // A round has settled: count it and let the other sessions have the thread
+            float net = s.bal - roundStart;
+            roundStart = s.bal;
+            settled = s.round;
+            stats.rounds++;
+            stats.net += net;
+            stats.netSquared += static_cast<double>(net) * net;
+            stats.add(s.result);
+            co_await pool.yield();
+        }
+    }
+
+public:
+    Session(CommandSource& commands, SessionPool& threads, const Rules& rules = Rules())
+        : player(deck), dealer(deck), table(deck, player, dealer), source(commands), pool(threads)
+    {
+        table.setVerbose(false);
+        table.setRules(rules);
+        deck.build(rules.decks);
+    }
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    Table& getTable() { return table; }
+    Deck& getDeck() { return deck; }
+    // Only safe to read once the session has finished
+    const SimResult& getStats() const { return stats; }
+    // The table as of the last command, safe to read from any thread
+    TableSnapshot getView()
+    {
+        std::lock_guard<std::mutex> guard(viewLock);
+        return view;
+    }
+
+    // Sit down with `bankroll` and play up to `rounds` rounds on the pool
+    void start(float bankroll, uint64_t rounds)
+    {
+        table.newGame(bankroll);
+        publish();
+        task = play(rounds);
+        task.getHandle().promise().pool = &pool;
+        pool.join();
+        pool.schedule(task.getHandle());
+    }
+};
@@ -0,0 +1,133 @@
+/*
+* @file ShoePipeline.h
+* @brief Producer threads that shuffle shoes ahead of the simulation workers.
+*
+* This file defines `ShoePipeline`, a bounded ring of shuffled shoes. Producer threads take shoe
+* numbers in order, shuffle each one with shuffleShoe() into the slot for its number, and mark it
+* ready; simulation workers take the ready shoes in the same order, play them, and hand the slot
+* back. Shuffling an eight-deck shoe is a sizable share of playing it, and this way it happens on
+* other threads while the workers play, so a worker only waits when the producers fall behind.
+*
+* The ticket for a slot is the shoe's position in the run. Each slot carries a sequence number
+* (Vyukov's bounded queue): it equals the position when the slot is free for that shoe and the
+* position plus one once the shoe is in it, and giving it back moves it one lap ahead. A shoe
+* comes out exactly as Deck::startShoe() would have shuffled it, so the totals of a run don't
+* depend on whether the workers shuffle for themselves or are fed by the pipeline.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class ShoePipeline
+{
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> sequence{ 0 };
+        Xoshiro256 rng;                     // Where the shuffle left the generator
+        uint8_t types[MAX_SHOE_CARDS];
+    };
+
+    uint64_t seed;
+    ShoeSampling sampling;
+    int decks;
+    uint64_t first;
+    uint64_t count;
+    size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<uint64_t> produced{ 0 };   // Next position a producer takes
+    alignas(64) std::atomic<uint64_t> consumed{ 0 };   // Next position a consumer takes
+    std::atomic<uint64_t> producerStalls{ 0 };
+    std::atomic<uint64_t> consumerStalls{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::vector<std::thread> producers;
+
+    void produce()
+    {
+        for (uint64_t k = produced.fetch_add(1); k < count; k = produced.fetch_add(1))
+        {
+            Slot& slot = slots[k % capacity];
+            // Wait for the consumer of the shoe one lap back to hand the slot over
+            if (slot.sequence.load(std::memory_order_acquire) != k)
+            {
+                producerStalls.fetch_add(1, std::memory_order_relaxed);
+                while (slot.sequence.load(std::memory_order_acquire) != k)
+                {
+                    if (stopping.load(std::memory_order_relaxed))
+                        return;
+                    std::this_thread::yield();
+                }
+            }
+            shuffleShoe(seed, first + k, sampling, decks, slot.types, slot.rng);
+            slot.sequence.store(k + 1, std::memory_order_release);
+        }
+    }
+
+public:
+    /*******************************************************************************************
+    * Shuffle shoes `first` to `first + shoes - 1` of the sequence `seed`, `decks` decks each,
+    * on `threads` producer threads, keeping at most `depth` of them ahead of the consumers
+    ********************************************************************************************/
+    ShoePipeline(uint64_t shoeSeed, ShoeSampling mode, int deckCount, uint64_t firstShoe, uint64_t shoes,
+        int threads = 1, size_t depth = 64)
+        : seed(shoeSeed), sampling(mode), decks(std::max(1, std::min(deckCount, MAX_SHOE_CARDS / 52))),
+        first(firstShoe), count(shoes), capacity(std::max<size_t>(depth, 2)), slots(new Slot[capacity])
+    {
+        for (size_t i = 0; i < capacity; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        for (int t = 0; t < std::max(threads, 1); t++)
+            producers.emplace_back(&ShoePipeline::produce, this);
+    }
+
+    ~ShoePipeline()
+    {
+        stopping.store(true);
+        for (std::thread& t : producers)
+            t.join();
+    }
+
+    ShoePipeline(const ShoePipeline&) = delete;
+    ShoePipeline& operator=(const ShoePipeline&) = delete;
+
+    int getDecks() const { return decks; }
+    uint64_t getProducerStalls() const { return producerStalls.load(); }
+    uint64_t getConsumerStalls() const { return consumerStalls.load(); }
+
+    /*******************************************************************************************
+    * Take the next shoe, waiting until it has been shuffled. Returns false once every shoe has
+    * been handed out. `shoe` is its number in the sequence and `ticket` goes back to release()
+    * once the deck has copied it.
+    ********************************************************************************************/
+    bool acquire(uint64_t& shoe, uint64_t& ticket, const uint8_t*& types, Xoshiro256& rng)
+    {
+        uint64_t k = consumed.fetch_add(1);
+        if (k >= count)
+            return false;
+        Slot& slot = slots[k % capacity];
+        if (slot.sequence.load(std::memory_order_acquire) != k + 1)
+        {
+            consumerStalls.fetch_add(1, std::memory_order_relaxed);
+            while (slot.sequence.load(std::memory_order_acquire) != k + 1)
+                std::this_thread::yield();
+        }
+        shoe = first + k;
+        ticket = k;
+        types = slot.types;
+        rng = slot.rng;
+        return true;
+    }
+
+    // The slot is free for the shoe one lap ahead
+    void release(uint64_t ticket)
+    {
+        slots[ticket % capacity].sequence.store(ticket + capacity, std::memory_order_release);
+    }
+};
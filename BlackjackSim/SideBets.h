@@ -0,0 +1,328 @@
+/*
+* @file SideBets.h
+* @brief Perfect Pairs, 21+3 and Lucky Ladies, settled off the initial deal, with exact odds.
+*
+* Each side bet is a struct with the same static members: how many cards of the deal it looks at,
+* its outcomes and what they pay, and outcome(), which settles a deal with one lookup in a table
+* built the first time the bet is used. The deal is four card types (cardType(), suits included)
+* in the order player, player, up card, hole card.
+*
+* sideBetOdds() walks every way a shoe of any composition can deal the bet's cards and returns
+* the exact probability of each outcome, so sideBetEV() is exact for the cards left at any point
+* in a shoe, not just off the top.
+*
+* The bets the table settles are fixed at build time. Define BJ_SIDE_BETS as a list of them, e.g.
+* BJ_SIDE_BETS=PerfectPairs,TwentyOnePlusThree, and `ActiveSideBets` becomes a ledger of exactly
+* those. Without it the list is empty, and Table's call to settle it compiles to nothing.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+const int CARD_TYPES = 52;      // cardIndex() - 1, i.e. rank * 4 + suit
+
+inline int cardType(const Card& c) { return cardIndex(c.getRank(), c.getSuit()) - 1; }
+inline int typeRank(int type) { return type / 4; }         // Rank: Ace = 0 ... King = 12
+inline int typeSuit(int type) { return type % 4; }
+inline bool typeRed(int type) { return typeSuit(type) < 2; }   // Hearts and diamonds
+inline int typeValue(int type) { return typeRank(type) >= 9 ? 10 : typeRank(type) + 1; }
+
+// Outcome 0 of every bet loses the stake; the rest pay pays(outcome) to one
+struct PerfectPairs
+{
+    static const int CARDS = 2;
+    static const int OUTCOMES = 4;
+    static const char* name() { return "Perfect Pairs"; }
+    static const char* outcomeName(int o)
+    {
+        static const char* const names[OUTCOMES] = { "no pair", "mixed pair", "colored pair", "perfect pair" };
+        return names[o];
+    }
+    static int pays(int o)
+    {
+        static const int table[OUTCOMES] = { -1, 6, 12, 25 };
+        return table[o];
+    }
+
+    static int classify(int a, int b)
+    {
+        if (typeRank(a) != typeRank(b))
+            return 0;
+        if (typeSuit(a) == typeSuit(b))
+            return 3;
+        return typeRed(a) == typeRed(b) ? 2 : 1;
+    }
+
+    static int outcome(const int* deal)
+    {
+        static const std::vector<uint8_t> table = [] {
+            std::vector<uint8_t> t(CARD_TYPES * CARD_TYPES);
+            for (int a = 0; a < CARD_TYPES; a++)
+                for (int b = 0; b < CARD_TYPES; b++)
+                    t[a * CARD_TYPES + b] = static_cast<uint8_t>(classify(a, b));
+            return t;
+        }();
+        return table[deal[0] * CARD_TYPES + deal[1]];
+    }
+
+    // Nothing is settled before all the bet's cards are out
+    static int decided(const int*, int) { return -1; }
+};
+
+// The player's two cards and the dealer's up card as a three-card poker hand
+struct TwentyOnePlusThree
+{
+    static const int CARDS = 3;
+    static const int OUTCOMES = 6;
+    static const char* name() { return "21+3"; }
+    static const char* outcomeName(int o)
+    {
+        static const char* const names[OUTCOMES] = { "nothing", "flush", "straight", "three of a kind",
+            "straight flush", "suited trips" };
+        return names[o];
+    }
+    static int pays(int o)
+    {
+        static const int table[OUTCOMES] = { -1, 5, 10, 30, 40, 100 };
+        return table[o];
+    }
+
+    static int classify(int a, int b, int c)
+    {
+        int r[3] = { typeRank(a), typeRank(b), typeRank(c) };
+        bool flush = typeSuit(a) == typeSuit(b) && typeSuit(b) == typeSuit(c);
+        if (r[0] == r[1] && r[1] == r[2])
+            return flush ? 5 : 3;
+        std::sort(r, r + 3);
+        // The Ace plays low (A-2-3) or high (Q-K-A), but doesn't wrap around (K-A-2)
+        bool straight = (r[1] == r[0] + 1 && r[2] == r[1] + 1) || (r[0] == 0 && r[1] == 11 && r[2] == 12);
+        if (straight)
+            return flush ? 4 : 2;
+        return flush ? 1 : 0;
+    }
+
+    static int outcome(const int* deal)
+    {
+        static const std::vector<uint8_t> table = [] {
+            std::vector<uint8_t> t(CARD_TYPES * CARD_TYPES * CARD_TYPES);
+            for (int a = 0; a < CARD_TYPES; a++)
+                for (int b = 0; b < CARD_TYPES; b++)
+                    for (int c = 0; c < CARD_TYPES; c++)
+                        t[(a * CARD_TYPES + b) * CARD_TYPES + c] = static_cast<uint8_t>(classify(a, b, c));
+            return t;
+        }();
+        return table[(deal[0] * CARD_TYPES + deal[1]) * CARD_TYPES + deal[2]];
+    }
+
+    static int decided(const int*, int) { return -1; }
+};
+
+// The player's first two cards totalling 20, with the top prize needing a dealer blackjack too
+struct LuckyLadies
+{
+    static const int CARDS = 4;
+    static const int OUTCOMES = 6;
+    static const int QUEEN_OF_HEARTS = static_cast<int>(Rank::Queen) * 4 + static_cast<int>(Suit::Hearts);
+    static const char* name() { return "Lucky Ladies"; }
+    static const char* outcomeName(int o)
+    {
+        static const char* const names[OUTCOMES] = { "no 20", "any 20", "suited 20", "matched 20",
+            "queen of hearts pair", "queen of hearts pair and dealer blackjack" };
+        return names[o];
+    }
+    static int pays(int o)
+    {
+        static const int table[OUTCOMES] = { -1, 4, 10, 19, 125, 1000 };
+        return table[o];
+    }
+
+    // The player's cards alone; the dealer only matters to a queen of hearts pair. Any two-card 20
+    // counts, so an Ace plays as 11 and A-9 is a 20.
+    static int classify(int a, int b)
+    {
+        int total = typeValue(a) + typeValue(b);
+        if (total != 20 && !(total == 10 && (typeRank(a) == 0 || typeRank(b) == 0)))
+            return 0;
+        if (a == QUEEN_OF_HEARTS && b == QUEEN_OF_HEARTS)
+            return 4;
+        if (a == b)
+            return 3;
+        return typeSuit(a) == typeSuit(b) ? 2 : 1;
+    }
+
+    static int outcome(const int* deal)
+    {
+        static const std::vector<uint8_t> table = [] {
+            std::vector<uint8_t> t(CARD_TYPES * CARD_TYPES);
+            for (int a = 0; a < CARD_TYPES; a++)
+                for (int b = 0; b < CARD_TYPES; b++)
+                    t[a * CARD_TYPES + b] = static_cast<uint8_t>(classify(a, b));
+            return t;
+        }();
+        int o = table[deal[0] * CARD_TYPES + deal[1]];
+        // The dealer's blackjack is an Ace and a ten
+        if (o == 4 && typeValue(deal[2]) + typeValue(deal[3]) == 11
+            && (typeRank(deal[2]) == 0 || typeRank(deal[3]) == 0))
+            return 5;
+        return o;
+    }
+
+    // Only a queen of hearts pair has to wait for the dealer's cards
+    static int decided(const int* deal, int cards)
+    {
+        if (cards < 2)
+            return -1;
+        int o = classify(deal[0], deal[1]);
+        return o == 4 ? -1 : o;
+    }
+};
+
+// Every way `left` cards can deal the rest of the bet's cards, weighted by probability `p`
+template<typename Bet>
+void addSideBetOdds(int counts[CARD_TYPES], int left, int* deal, int cards, double p, double* odds)
+{
+    int settled = cards == Bet::CARDS ? Bet::outcome(deal) : Bet::decided(deal, cards);
+    if (settled >= 0)
+    {
+        odds[settled] += p;
+        return;
+    }
+    for (int t = 0; t < CARD_TYPES; t++)
+    {
+        if (counts[t] == 0)
+            continue;
+        deal[cards] = t;
+        double q = p * counts[t] / left;
+        counts[t]--;
+        addSideBetOdds<Bet>(counts, left - 1, deal, cards + 1, q, odds);
+        counts[t]++;
+    }
+}
+
+/*******************************************************************************************
+* Exact probability of every outcome of `Bet` when the deal comes from a shoe holding
+* counts[type] cards of each card type
+********************************************************************************************/
+template<typename Bet>
+std::array<double, Bet::OUTCOMES> sideBetOdds(const int counts[CARD_TYPES])
+{
+    std::array<double, Bet::OUTCOMES> odds = {};
+    int shoe[CARD_TYPES], left = 0;
+    for (int t = 0; t < CARD_TYPES; t++)
+    {
+        shoe[t] = counts[t];
+        left += counts[t];
+    }
+    int deal[4];
+    if (left >= Bet::CARDS)
+        addSideBetOdds<Bet>(shoe, left, deal, 0, 1.0, odds.data());
+    return odds;
+}
+
+// Expected result per unit staked on `Bet` with this shoe left
+template<typename Bet>
+double sideBetEV(const int counts[CARD_TYPES])
+{
+    std::array<double, Bet::OUTCOMES> odds = sideBetOdds<Bet>(counts);
+    double ev = 0;
+    for (int o = 0; o < Bet::OUTCOMES; o++)
+        ev += odds[o] * Bet::pays(o);
+    return ev;
+}
+
+// Cards of each type still to be dealt from the deck; returns how many there are
+inline int shoeComposition(const Deck& deck, int counts[CARD_TYPES])
+{
+    for (int t = 0; t < CARD_TYPES; t++)
+        counts[t] = 0;
+    for (size_t i = deck.getNext(); i < deck.cards.size(); i++)
+        counts[cardType(deck.cards[i])]++;
+    return static_cast<int>(deck.cards.size() - deck.getNext());
+}
+
+// One side bet's results over every round it was staked, one unit a round
+struct SideBetTally
+{
+    const char* name = "";
+    int outcomes = 0;
+    uint64_t rounds = 0;
+    double net = 0;
+    uint64_t hits[8] = {};
+
+    double getEdge() const { return rounds > 0 ? net / rounds : 0.0; }
+    void print(const char* (*outcomeName)(int)) const
+    {
+        std::printf("%s: %llu rounds  Net: %.0f  Edge: %.3f%%\n", name, static_cast<unsigned long long>(rounds),
+            net, getEdge() * 100.0);
+        for (int o = 1; o < outcomes; o++)
+            std::printf("  %-42s %10llu\n", outcomeName(o), static_cast<unsigned long long>(hits[o]));
+    }
+};
+
+/*******************************************************************************************
+* Settles every bet in the list off each deal. Each one stakes one unit a round, kept apart from
+* the main bet. With an empty list there is nothing to store and settle() does nothing.
+********************************************************************************************/
+template<typename... Bets>
+class SideBetLedger
+{
+public:
+    static const int COUNT = sizeof...(Bets);
+
+private:
+    std::array<SideBetTally, COUNT> tallies;
+
+    template<typename Bet>
+    void settleOne(SideBetTally& t, const int* deal)
+    {
+        int o = Bet::outcome(deal);
+        t.rounds++;
+        t.net += Bet::pays(o);
+        t.hits[o]++;
+    }
+
+    template<typename Bet>
+    void printOne(const SideBetTally& t) const { t.print(&Bet::outcomeName); }
+
+public:
+    SideBetLedger()
+    {
+        int i = 0;
+        int expand[] = { 0, (tallies[i].name = Bets::name(), tallies[i++].outcomes = Bets::OUTCOMES, 0)... };
+        (void)expand;
+        (void)i;
+    }
+
+    // `deal` is the player's two cards, the up card and the hole card as card types
+    void settle(const int* deal)
+    {
+        int i = 0;
+        int expand[] = { 0, (settleOne<Bets>(tallies[i++], deal), 0)... };
+        (void)expand;
+        (void)deal;
+        (void)i;
+    }
+
+    const std::array<SideBetTally, COUNT>& getTallies() const { return tallies; }
+
+    void print() const
+    {
+        int i = 0;
+        int expand[] = { 0, (printOne<Bets>(tallies[i++]), 0)... };
+        (void)expand;
+        (void)i;
+    }
+};
+
+#ifdef BJ_SIDE_BETS
+using ActiveSideBets = SideBetLedger<BJ_SIDE_BETS>;
+#else
+using ActiveSideBets = SideBetLedger<>;
+#endif
@@ -0,0 +1,434 @@
+/*
+* @file Simulation.h
+* @brief Headless engine that plays rounds through the Table state machine without a window.
+*
+* This file defines the `Simulator` class, which owns its own Deck, Player and Dealer, drives
+* a `Table` with basic strategy instead of mouse clicks, and collects the results in `SimResult`.
+* Given a `CountStrategy` it bets and plays by the Hi-Lo true count instead. compareStrategies()
+* plays two strategies on the same shoes and measures their difference from the paired results.
+* runShoes() plays a range of shoes on a WorkStealingPool, one Simulator per worker, or every
+* shoe a ShoePipeline shuffles ahead of its workers.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct SimResult
+{
+    uint64_t rounds = 0;
+    uint64_t wins = 0;
+    uint64_t losses = 0;
+    uint64_t pushes = 0;
+    uint64_t blackjacks = 0;
+    uint64_t surrenders = 0;
+    double wagered = 0;  // Total of the initial bets
+    double net = 0;      // Player's net result over every round
+    double netSquared = 0;  // Sum of the squared round results, for the variance
+
+    // Expected value per unit of initial bet
+    double getEdge() const { return wagered > 0 ? net / wagered : 0.0; }
+    // Standard deviation of one round's result
+    double getStdDev() const
+    {
+        if (rounds < 2)
+            return 0.0;
+        double mean = net / rounds;
+        return std::sqrt(std::max(0.0, (netSquared - mean * net) / (rounds - 1)));
+    }
+    // Mean result over its standard deviation, the EV per unit of risk
+    double getScore() const
+    {
+        double sd = getStdDev();
+        return sd > 0 ? net / rounds / sd : 0.0;
+    }
+
+    void add(const SimResult& o)
+    {
+        rounds += o.rounds;
+        wins += o.wins;
+        losses += o.losses;
+        pushes += o.pushes;
+        blackjacks += o.blackjacks;
+        surrenders += o.surrenders;
+        wagered += o.wagered;
+        net += o.net;
+        netSquared += o.netSquared;
+    }
+
+    void add(RoundResult r)
+    {
+        switch (r)
+        {
+        case RoundResult::Blackjack: blackjacks++; wins++; break;
+        case RoundResult::Win: wins++; break;
+        case RoundResult::Loss: losses++; break;
+        case RoundResult::Push: pushes++; break;
+        case RoundResult::Surrender: surrenders++; losses++; break;
+        default: break;
+        }
+    }
+
+    void print() const
+    {
+        std::printf("Rounds: %llu  Wins: %llu  Losses: %llu  Pushes: %llu  Blackjacks: %llu  Surrenders: %llu\n",
+            static_cast<unsigned long long>(rounds), static_cast<unsigned long long>(wins),
+            static_cast<unsigned long long>(losses), static_cast<unsigned long long>(pushes),
+            static_cast<unsigned long long>(blackjacks), static_cast<unsigned long long>(surrenders));
+        std::printf("Wagered: %.0f  Net: %.2f  Player edge: %.3f%%\n", wagered, net, getEdge() * 100.0);
+    }
+};
+
+// Everything about one played round, handed to the recorder once it has settled
+struct HandRecord
+{
+    uint64_t round = 0;
+    float trueCount = 0;    // When the bet was placed
+    float bet = 0;          // Initial bet
+    float net = 0;
+    int playerTotal = 0;
+    int dealerTotal = 0;
+    int upcard = 0;         // Ace = 1
+    int playerCards = 0;
+    Action firstAction = Action::None;
+    RoundResult result = RoundResult::None;
+};
+
+class Simulator
+{
+private:
+    Deck deck;
+    Player player;
+    Dealer dealer;
+    Table table;
+    float unit = 1.0f;
+    bool bottomless = true;     // Top the balance up every round instead of playing a real bankroll
+    const CountStrategy* strategy = nullptr;
+    std::function<void(const HandRecord&)> recorder;
+    uint64_t roundsPlayed = 0;
+    Action firstAction = Action::None;
+
+public:
+    Simulator()
+        : player(deck), dealer(deck), table(deck, player, dealer)
+    {
+        table.setVerbose(false);
+        deck.populate();
+        deck.shuffle();
+    }
+
+    Deck& getDeck() { return deck; }
+    Table& getTable() { return table; }
+    // Play a real bankroll from now on: bets come out of it and it can run out
+    void setBankroll(float bankroll)
+    {
+        bottomless = false;
+        table.newGame(bankroll);
+    }
+    void setUnit(float value) { unit = value; }
+    float getUnit() const { return unit; }
+
+    // Change the rules; the shoe is rebuilt with the rules' number of decks
+    void setRules(const Rules& rules)
+    {
+        table.setRules(rules);
+        deck.build(rules.decks);
+    }
+    // Called after every round playRound() plays; an empty function turns recording off
+    void setRecorder(std::function<void(const HandRecord&)> value) { recorder = std::move(value); }
+    // Bet and play by the count; nullptr goes back to flat bets and basic strategy
+    void setStrategy(const CountStrategy* value) { strategy = value; }
+
+    // Hi-Lo running count divided by the decks left to deal
+    double getTrueCount() const
+    {
+        int left = deck.getLength();
+        return left > 0 ? deck.getRunningCount() * 52.0 / left : 0.0;
+    }
+    // The same count without the dealer's hole card while it is face down, which is all the
+    // player may use for insurance and index plays
+    double getVisibleTrueCount() const
+    {
+        const TableSnapshot& s = table.getSnapshot();
+        if (!s.holeCardHidden || s.dealerCount < 2)
+            return getTrueCount();
+        int left = deck.getLength() + 1;
+        return (deck.getRunningCount() - hiLoTag(s.dealerCards[1])) * 52.0 / left;
+    }
+    Player& getPlayer() { return player; }
+
+    /*******************************************************************************************
+    * Bet and deal, and answer insurance if it is offered. Leaves the table at the player's first
+    * decision, or already settled when a natural ended the round. Returns the bet placed.
+    ********************************************************************************************/
+    float dealRound()
+    {
+        // Unless it plays a bankroll, the headless player never runs out of money
+        if (bottomless)
+            player.setBal(10000.0f);
+        if (table.getGameOver())
+            return 0;
+        float bet = std::min(strategy ? unit * strategy->betUnits(getTrueCount()) : unit, player.getBal());
+        table.submit(CommandType::AddChip, bet);
+        table.submit(CommandType::Deal);
+        table.update();
+        if (table.getSnapshot().state == RoundState::Insurance)
+        {
+            bool insure = strategy && strategy->takeInsurance(getVisibleTrueCount());
+            table.submit(insure ? CommandType::Insurance : CommandType::DeclineInsurance);
+            table.update();
+        }
+        return bet;
+    }
+
+    // Play out the rest of the player's turn with basic strategy; the table settles the round
+    void finishRound()
+    {
+        bool first = true;
+        firstAction = Action::None;
+        while (table.getSnapshot().state == RoundState::PlayerTurn)
+        {
+            const TableSnapshot& s = table.getSnapshot();
+            int upcard = s.dealerCards[0].getValue();
+            Action action;
+            {
+                BJ_PROFILE_SCOPE(Phase::Decision);
+                action = strategy
+                    ? strategy->play(s.playerTotal, s.playerSoft, upcard, s.canDouble, s.canSurrender, getVisibleTrueCount())
+                    : basicStrategy(s.playerTotal, s.playerSoft, upcard, s.canDouble, s.canSurrender);
+            }
+            if (first)
+                firstAction = action;
+            first = false;
+            switch (action)
+            {
+            case Action::Hit: table.submit(CommandType::Hit); break;
+            case Action::DoubleDown: table.submit(CommandType::DoubleDown); break;
+            case Action::Surrender: table.submit(CommandType::Surrender); break;
+            default: table.submit(CommandType::Stand); break;
+            }
+            table.update();
+        }
+    }
+
+    // Play one round, returns the player's net result
+    float playRound(SimResult& stats)
+    {
+        BJ_PROFILE_SCOPE(Phase::Round);
+        float trueCount = recorder ? static_cast<float>(getTrueCount()) : 0.0f;
+        // A natural can settle the round inside dealRound(), so count from before the bet is placed
+        if (bottomless)
+            player.setBal(10000.0f);
+        // A bankroll that has run out plays no more rounds, and counts none
+        if (table.getGameOver())
+            return 0;
+        float start = player.getBal();
+        float bet = dealRound();
+        finishRound();
+
+        float net = player.getBal() - start;
+        stats.rounds++;
+        stats.wagered += bet;
+        stats.net += net;
+        stats.netSquared += static_cast<double>(net) * net;
+        stats.add(table.getSnapshot().result);
+        roundsPlayed++;
+
+        if (recorder)
+        {
+            const TableSnapshot& s = table.getSnapshot();
+            HandRecord r;
+            r.round = roundsPlayed;
+            r.trueCount = trueCount;
+            r.bet = bet;
+            r.net = net;
+            r.playerTotal = s.playerTotal;
+            r.dealerTotal = s.dealerTotal;
+            r.upcard = s.dealerCards[0].getValue();
+            r.playerCards = s.playerCount;
+            r.firstAction = firstAction;
+            r.result = s.result;
+            recorder(r);
+        }
+        return net;
+    }
+
+    // Play shoe `n` of the deck's shoe sequence from the first card to the cut card
+    void playShoe(uint64_t n, SimResult& stats)
+    {
+        deck.startShoe(n);
+        playToCut(stats);
+    }
+
+    // Play rounds up to the cut card. A continuous shuffler has none, so there a shoe is as many
+    // cards as the cut card would have let through. A bankroll that runs out ends it early.
+    void playToCut(SimResult& stats)
+    {
+        size_t cut = static_cast<size_t>(deck.cards.size() * table.getRules().penetration), dealt = 0;
+        do
+        {
+            playRound(stats);
+            const TableSnapshot& s = table.getSnapshot();
+            dealt += s.playerCount + s.dealerCount;
+        }
+        while (!table.needsShuffle() && !table.getGameOver() && (!deck.getContinuous() || dealt < cut));
+    }
+
+    // Play the next shoe the pipeline has shuffled; returns false once it has none left
+    bool playShoe(ShoePipeline& pipeline, SimResult& stats)
+    {
+        uint64_t n, ticket;
+        const uint8_t* types;
+        Xoshiro256 after;
+        if (!pipeline.acquire(n, ticket, types, after))
+            return false;
+        deck.loadShoe(n, types, 52 * static_cast<size_t>(pipeline.getDecks()), after);
+        pipeline.release(ticket);
+        playToCut(stats);
+        return true;
+    }
+
+    SimResult run(uint64_t rounds)
+    {
+        SimResult stats;
+        for (uint64_t i = 0; i < rounds; i++)
+            playRound(stats);
+        return stats;
+    }
+};
+
+// Paired comparison of two strategies over the same shoe sequence
+struct Comparison
+{
+    SimResult a;
+    SimResult b;
+    uint64_t blocks = 0;
+    double diffPerRound = 0;        // Net result per round, b minus a
+    double stdErr = 0;              // Standard error of diffPerRound
+    double varianceReduction = 0;   // Variance of the difference on independent shoes over the paired variance
+};
+
+/*******************************************************************************************
+* Play `shoes` shoes with each strategy (nullptr is flat betting and basic strategy). Both see
+* shoe n of the same sequence, so the difference in their results is mostly the strategy and
+* not the cards. Shoes are grouped into blocks that are independent of each other: one shoe,
+* an antithetic pair, or a full set of 52 strata; the standard error comes from the blocks.
+********************************************************************************************/
+inline Comparison compareStrategies(const CountStrategy* a, const CountStrategy* b, uint64_t shoes, uint64_t seed,
+    ShoeSampling sampling)
+{
+    uint64_t blockSize = sampling == ShoeSampling::Antithetic ? 2 : (sampling == ShoeSampling::Stratified ? 52 : 1);
+    Simulator simA, simB;
+    simA.setStrategy(a);
+    simB.setStrategy(b);
+    simA.getDeck().setShoeSequence(seed, sampling);
+    simB.getDeck().setShoeSequence(seed, sampling);
+
+    Comparison c;
+    double sumA = 0, sumB = 0, sumD = 0, sqA = 0, sqB = 0, sqD = 0;
+    for (uint64_t shoe = 0; shoe + blockSize <= shoes; shoe += blockSize)
+    {
+        double startA = c.a.net, startB = c.b.net;
+        for (uint64_t i = shoe; i < shoe + blockSize; i++)
+        {
+            simA.playShoe(i, c.a);
+            simB.playShoe(i, c.b);
+        }
+        double x = c.a.net - startA, y = c.b.net - startB;
+        sumA += x; sqA += x * x;
+        sumB += y; sqB += y * y;
+        sumD += y - x; sqD += (y - x) * (y - x);
+        c.blocks++;
+    }
+    if (c.blocks < 2 || c.a.rounds == 0)
+        return c;
+
+    double n = static_cast<double>(c.blocks);
+    double varA = (sqA - sumA * sumA / n) / (n - 1);
+    double varB = (sqB - sumB * sumB / n) / (n - 1);
+    double varD = (sqD - sumD * sumD / n) / (n - 1);
+    // Both strategies play about the same number of rounds per shoe
+    double roundsPerBlock = (c.a.rounds + c.b.rounds) / (2.0 * n);
+    c.diffPerRound = sumD / n / roundsPerBlock;
+    c.stdErr = std::sqrt(std::max(0.0, varD) / n) / roundsPerBlock;
+    c.varianceReduction = varD > 0 ? (varA + varB) / varD : 0.0;
+    return c;
+}
+
+/*******************************************************************************************
+* Play shoes `first` to `first + shoes - 1` of the sequence `seed` under `rules` (a nullptr
+* strategy is flat betting and basic strategy) on the pool's workers. Each shoe is the same
+* whichever worker plays it, so the totals only depend on the seed. Each worker builds its own
+* Simulator and results the first time it runs, after the pool has pinned it, so its shoe,
+* hands and counters live on its own node.
+********************************************************************************************/
+inline SimResult runShoes(WorkStealingPool& pool, uint64_t first, uint64_t shoes, uint64_t seed,
+    const CountStrategy* strategy = nullptr, const Rules& rules = Rules())
+{
+    struct WorkerState
+    {
+        Simulator sim;
+        SimResult stats;
+    };
+    std::vector<std::unique_ptr<WorkerState>> workers(pool.getThreads());
+    pool.run(shoes, [&](int worker, uint64_t begin, uint64_t end) {
+        std::unique_ptr<WorkerState>& w = workers[worker];
+        if (!w)
+        {
+            w.reset(new WorkerState());
+            w->sim.setRules(rules);
+            w->sim.setStrategy(strategy);
+            w->sim.getDeck().setShoeSequence(seed, ShoeSampling::Independent);
+        }
+        for (uint64_t n = begin; n < end; n++)
+            w->sim.playShoe(first + n, w->stats);
+    });
+    SimResult total;
+    for (const std::unique_ptr<WorkerState>& w : workers)
+    {
+        if (w)
+            total.add(w->stats);
+    }
+    return total;
+}
+
+/*******************************************************************************************
+* Play every shoe `pipeline` hands out on `threads` workers, which never shuffle for
+* themselves. The shoes come out as Deck::startShoe() makes them, so the totals match runShoes()
+* over the same shoes up to the order they are added in. `rules.decks` must match the pipeline.
+********************************************************************************************/
+inline SimResult runShoes(ShoePipeline& pipeline, int threads, const CountStrategy* strategy = nullptr,
+    const Rules& rules = Rules())
+{
+    if (threads <= 0)
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<SimResult> results(threads);
+    auto worker = [&](int me) {
+        Simulator sim;
+        sim.setRules(rules);
+        sim.setStrategy(strategy);
+        SimResult stats;
+        while (sim.playShoe(pipeline, stats))
+            ;
+        results[me] = stats;
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(worker, t);
+    worker(0);
+    for (std::thread& t : pool)
+        t.join();
+    SimResult total;
+    for (const SimResult& r : results)
+        total.add(r);
+    return total;
+}
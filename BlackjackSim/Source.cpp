@@ -15,31 +15,78 @@ GLuint textures[66];
 #include <string>
 #include <stdio.h>
 #include <cmath>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
 #include <vector>
 #include <chrono>
 #include <thread>
+#include <memory>
+#include <algorithm>
+// Keeps Windows.h from pulling in the old winsock.h, which clashes with winsock2.h in JobServer.h
+#define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #include <cstring>
+#include <cstdlib>
+#include <new>
 #include "PlayingCards.h"
 #include "Player.h"
 #include "Dealer.h"
 #include "Sprite.h"
+#include "Strategy.h"
+#include "GameState.h"
+#include "Rules.h"
+#include "SideBets.h"
+#include "Table.h"
+#include "Numa.h"
+#include "Scheduler.h"
+#include "ShoePipeline.h"
+#include "Simulation.h"
+#include "Rollout.h"
+#include "BatchSim.h"
+#include "Optimizer.h"
+#include "ExactEdge.h"
+#include "Advisor.h"
+#include "Bankroll.h"
+#include "ColumnarExport.h"
+#include "Replay.h"
+#include "Session.h"
+#include "JobServer.h"
+#include "Cluster.h"
+#include "FrameStats.h"
+#include "Animation.h"
+#include "Arena.h"
+
+// Every heap allocation in the program goes through here so that heapAllocations() can count it
+void* operator new(std::size_t size)
+{
+    heapAllocations()++;
+    if (void* p = std::malloc(size > 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+#ifdef __GNUC__
+// GCC sees through the replacement and takes the free() below for a mismatch
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
 
 using namespace std;
 const int CANVAS_HEIGHT = 600;
 const int CANVAS_WIDTH = 800;
-bool roundStarted = false;
-bool roundOver = false;
-bool firstTurn = true;
-bool gameOver = false;
-
-//Initialize the deck, player, dealer
-Deck deck;
-Player player(deck);
-Dealer dealer(deck);
+bool showFrameStats = false;
+bool showHint = false;
+bool redisplayPending = false;
+
+// The window is one player at a session of its own. Clicks are posted to it, the session plays
+// them on its thread and the renderer only ever reads the snapshots it publishes.
+HumanSource human;
+std::unique_ptr<SessionPool> sessionPool;
+std::unique_ptr<Session> session;
+TableSnapshot view;
 //Initialize UI elements. Textures must be set in init() function
 Sprite background(0, 600, 800, 600);
 Sprite greenCover(300, 390, 300, 275);
@@ -56,6 +103,40 @@ Button surrender(644, 74);
 Sprite endScreen(200, 450, 400, 300);
 Sprite rules(10, 590, 200, 300);
 Sprite cardBack(0, 0, 110, 155);
+// Frame telemetry and pacing
+FrameStats frameStats;
+FramePacer framePacer(60);
+// Cards, the hole card flip and chips are animated; these track what has been queued this round
+Animator animator;
+// Built the first time the hint is switched on, it precomputes the off-the-top answers
+std::unique_ptr<Advisor> advisor;
+// Text formatted while drawing lives here until the next frame
+Arena textArena;
+uint64_t lastFrameAllocations = 0;
+int queuedPlayerCards = 0;
+int queuedDealerCards = 0;
+bool holeCardQueued = false;
+uint32_t animatedRound = 0;
+uint32_t paidRound = 0;
+const float BET_X = 140;
+const float BET_Y = 240;
+const int PLAYER_HAND_X = 300;
+const int PLAYER_HAND_Y = 270;
+const int DEALER_HAND_X = 300;
+const int DEALER_HAND_Y = 550;
+
+#ifdef _WIN32
+// Turn on vsync through WGL_EXT_swap_control if the driver has it
+void enableVsync(void)
+{
+    typedef BOOL(WINAPI* SwapIntervalProc)(int);
+    SwapIntervalProc swapInterval = (SwapIntervalProc)wglGetProcAddress("wglSwapIntervalEXT");
+    if (swapInterval)
+        swapInterval(1);
+}
+#else
+void enableVsync(void) {}
+#endif
 
 void init(void)
 {
@@ -192,10 +273,11 @@ void init(void)
     rules.setTexture(textures[65]);
     cardBack.setTexture(textures[53]);
 
-	// Populate deck now that textures are loaded
-    deck.populate();
-    // Shuffle
-	deck.shuffle();
+    // Cards take their textures when the shoe is built, so the session sits down now they are loaded
+    Rules tableRules;
+    sessionPool.reset(new SessionPool(1));
+    session.reset(new Session(human, *sessionPool, tableRules));
+    session->start(tableRules.startingBankroll, UINT64_MAX);
 }
 
 void write(GLfloat x, GLfloat y, const char* message)
@@ -237,118 +319,202 @@ void writeFloat(int x, int y, float num, int decimalPlaces)
     // Round the floating-point number
     float roundedNum = roundToDecimal(num, decimalPlaces);
 
-    // Convert the rounded number to a string with specified decimal places
-    stringstream ss;
-    ss << fixed << std::setprecision(decimalPlaces) << roundedNum;
-    string strNum = ss.str();
-
-    // Convert the string to const char* type to use in write function
-    const char* charNum = strNum.c_str();
+    // Format it with the specified decimal places into this frame's text arena
+    const char* charNum = textArena.format("%.*f", decimalPlaces, roundedNum);
 
     // Call the write function to display the rounded number
     write(x, y, charNum);
 }
 
-/**********************************************************
-* Wincase 1: blackjack
-* Wincase 2: normal win
-* Wincase 3: loss
-* Wincase 4: push
-* Wincase 5: error
-***********************************************************/
-void newRound(int money, int winCase)
+// Draw the frame time overlay in the top right corner
+void drawFrameStats(void)
+{
+    char line[64];
+    const FrameHistogram& cpu = frameStats.getCpu();
+    const FrameHistogram& gpu = frameStats.getGpu();
+    snprintf(line, sizeof(line), "CPU p50 %.2f p99 %.2f ms", cpu.percentile(50) / 1000.0, cpu.percentile(99) / 1000.0);
+    write(560, 585, line, 0.1);
+    snprintf(line, sizeof(line), "GPU p50 %.2f p99 %.2f ms", gpu.percentile(50) / 1000.0, gpu.percentile(99) / 1000.0);
+    write(560, 570, line, 0.1);
+    snprintf(line, sizeof(line), "Heap allocs last frame %llu", static_cast<unsigned long long>(lastFrameAllocations));
+    write(560, 555, line, 0.1);
+}
+
+// Draw the first `count` cards of a hand, each overlapping the one before it by half
+void drawCards(const Card* cards, int count, int x, int y)
+{
+    for (int i = 0; i < count; i++)
+    {
+        cards[i].draw(x, y);
+        x += cards[i].getWidth() / 2;
+    }
+}
+
+// Queue the deal animation for one card; the hole card travels face down
+void queueDeal(HandOwner owner)
+{
+    bool isDealer = owner == HandOwner::Dealer;
+    int& queued = isDealer ? queuedDealerCards : queuedPlayerCards;
+    const Card& c = isDealer ? view.dealerCards[queued] : view.playerCards[queued];
+    GLuint texture = (isDealer && queued == 1 && !holeCardQueued) ? cardBack.getTexture() : c.getTexture();
+    int x = (isDealer ? DEALER_HAND_X : PLAYER_HAND_X) + queued * c.getWidth() / 2;
+    int y = isDealer ? DEALER_HAND_Y : PLAYER_HAND_Y;
+    animator.dealCard(owner, texture, c.getWidth(), c.getHeight(), x, y);
+    queued++;
+}
+
+// Queue animations for whatever changed in the snapshot since the last frame
+void syncAnimations(void)
+{
+    if (view.round != animatedRound)
+    {
+        animatedRound = view.round;
+        animator.resetHands();
+        queuedPlayerCards = 0;
+        queuedDealerCards = 0;
+        holeCardQueued = false;
+        // Same order as the cards came out of the shoe
+        queueDeal(HandOwner::Player);
+        queueDeal(HandOwner::Dealer);
+        queueDeal(HandOwner::Player);
+        queueDeal(HandOwner::Dealer);
+    }
+    while (queuedPlayerCards < view.playerCount)
+        queueDeal(HandOwner::Player);
+
+    // Turn over the hole card, then deal out whatever the dealer drew
+    if (!view.holeCardHidden && view.dealerCount >= 2)
+    {
+        if (!holeCardQueued)
+        {
+            const Card& hole = view.dealerCards[1];
+            animator.flipCard(hole.getTexture(), cardBack.getTexture(), hole.getWidth(), hole.getHeight(),
+                DEALER_HAND_X + hole.getWidth() / 2, DEALER_HAND_Y);
+            holeCardQueued = true;
+        }
+        while (queuedDealerCards < view.dealerCount)
+            queueDeal(HandOwner::Dealer);
+    }
+
+    // Pay winners with a chip sliding over to the balance
+    if ((view.result == RoundResult::Win || view.result == RoundResult::Blackjack) && paidRound != view.round)
+    {
+        paidRound = view.round;
+        animator.moveChip(half.getTexture(), half.getWidth(), half.getHeight(), 450, 400, BET_X, BET_Y + 50);
+    }
+}
+
+// Draw the cards that have landed, the hole card cover and everything still in flight
+void drawHands(void)
 {
-    player.setBet(0);
-    roundStarted = false;
-    roundOver = false;
+    int playerCards = std::min(animator.getLanded(HandOwner::Player), view.playerCount);
+    int dealerCards = std::min(animator.getLanded(HandOwner::Dealer), view.dealerCount);
+    drawCards(view.playerCards, playerCards, PLAYER_HAND_X, PLAYER_HAND_Y);
+    if (dealerCards >= 2 && !animator.getHoleCardShown())
+    {
+        // Only the up card is drawn face up until the flip finishes
+        drawCards(view.dealerCards, 1, DEALER_HAND_X, DEALER_HAND_Y);
+        if (!animator.getFlipping())
+            cardBack.draw(DEALER_HAND_X + cardBack.getWidth() / 2, DEALER_HAND_Y);
+    }
+    else
+    {
+        drawCards(view.dealerCards, dealerCards, DEALER_HAND_X, DEALER_HAND_Y);
+    }
+    animator.draw();
 }
 
+// Write both totals; the dealer's stays hidden until the hole card has been turned over
+void drawTotals(void)
+{
+    char total[16];
+    snprintf(total, sizeof(total), "%d", view.playerTotal);
+    write(300, 85, "Total:", .25);
+    write(301, 85, "Total:", .25);
+    write(380, 85, total, .25);
+    write(381, 85, total, .25);
+
+    snprintf(total, sizeof(total), "%d", view.dealerTotal);
+    write(300, 565, "Total:", .25);
+    write(301, 565, "Total:", .25);
+    if (view.holeCardHidden || !animator.getHoleCardShown())
+    {
+        write(380, 565, "...", .25);
+        write(381, 565, "...", .25);
+    }
+    else
+    {
+        write(380, 565, total, .25);
+        write(381, 565, total, .25);
+    }
+}
+
+// Game tick: ask for the next frame
+void timer_func(int)
+{
+    redisplayPending = false;
+    glutPostRedisplay();
+}
+
+// Draws the last snapshot the session published; all game work happens on the session's thread
 void display_func(void)
 {
-    static int winCase;
+    static std::chrono::steady_clock::time_point lastFrame = std::chrono::steady_clock::now();
+    frameStats.beginFrame();
+    static uint64_t frameStartAllocations = heapAllocations();
+    lastFrameAllocations = heapAllocations() - frameStartAllocations;
+    frameStartAllocations = heapAllocations();
+    textArena.reset();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    animator.update(std::chrono::duration<double>(now - lastFrame).count());
+    lastFrame = now;
+    view = session->getView();
+    syncAnimations();
+
     glClear(GL_COLOR_BUFFER_BIT);
     // draw background and rules
     background.draw();
     rules.draw();
 
-    if (gameOver)
+    if (view.gameOver)
     {
         endScreen.draw();
     }
-    // If the game is not over, play the game
+    // If the game is not over, draw the table
     else
     {
-        // If both turns are over start a new round
-        if (player.getTurnOver() && dealer.getTurnOver())
-        {
-			player.newRound();
-			dealer.newRound();
-        }
-        // If the round hasn't started, d
-        if (!roundStarted)
-        {
+        bool inRound = view.state == RoundState::PlayerTurn || view.state == RoundState::Insurance;
+        // Between rounds the last hands stay up on a plain background
+        if (!inRound)
             greenCover.draw();
-            player.drawHand(textures);
-            dealer.drawHand(textures);
-            if (player.calculateHandTotal() > 0)
-            {
-                glDisable(GL_BLEND);
-                //Write the player's total
-                // Use string so we can concatenate the message with the total variable
-                string strTotal = to_string(player.getTotal());
-                // Convert the string to const char* type to use in write func
-                const char* charMessage = strTotal.c_str();
-                write(300, 85, "Total:", .25);
-                write(301, 85, "Total:", .25);
-                write(380, 85, charMessage, .25);
-                write(381, 85, charMessage, .25);
-
-                //Write the dealer's total
-                // Use string so we can concatenate the message with the total variable
-                strTotal = to_string(dealer.getTotal());
-                // Convert the string to const char* type to use in write func
-                charMessage = strTotal.c_str();
-                write(300, 565, "Total:", .25);
-                write(301, 565, "Total:", .25);
-                write(380, 565, charMessage, .25);
-                write(381, 565, charMessage, .25);
-                glEnable(GL_BLEND);
-            }
-        }
-        
-        if (roundStarted)
+        drawHands();
+
+        if (view.state == RoundState::Insurance)
         {
-            // If the deck is at 50%, reset the deck
-            if (deck.cards.size() <= 26)
-                deck.reset();
-            winCase = 0;
-			// Deal cards if the round has started and the player has no cards in hand, then draw the hands
-            if (player.hand.size() == 0)
+            // The hit and stand buttons take or turn down insurance against the dealer's Ace
+            hit.draw();
+            stand.draw();
+            glDisable(GL_BLEND);
+            for (int x = 0; x < 3; x++)
             {
-                player.hand.push_back(deck.deal());
-                dealer.hand.push_back(deck.deal());
-                player.hand.push_back(deck.deal());
-                dealer.hand.push_back(deck.deal());
-                int handTotal = 0;
-                std::cout << "Player's hand:" << std::endl;
-                for (const Card& c : player.hand)
+                for (int y = 0; y < 3; y++)
                 {
-                    handTotal += c.getValue();
-                    c.display();
-
+                    write(265 + x, 25 - y, view.evenMoney ? "Even" : "Ins.", 0.35);
+                    write(375 + x, 25 - y, "No", 0.35);
                 }
-                std::cout << "Player's total:  " << handTotal << std::endl << std::endl;
             }
-            player.drawHand(textures);
-            dealer.drawHand(textures);
-			// Draw hit and stand buttons, and double down and surrender if the player only has two cards
+            write(230, 130, view.evenMoney ? "Even money?" : "Insurance?", 0.14);
+            glEnable(GL_BLEND);
+        }
+        else if (inRound)
+        {
+            // Draw hit and stand buttons, and double down and surrender if the player only has two cards
             hit.draw();
             stand.draw();
-            if (player.hand.size() == 2)
-            {
+            if (view.canDouble)
                 doubleDown.draw();
+            if (view.canSurrender)
                 surrender.draw();
-            }
 
             glDisable(GL_BLEND);
             // triple bold
@@ -358,133 +524,23 @@ void display_func(void)
                 {
                     write(265 + x, 25 - y, "Hit", 0.35);
                     write(375 + x, 25 - y, "Stand", 0.35);
-                    if (player.hand.size() == 2)
-                    {
+                    if (view.canDouble)
                         write(535 + x, 25 - y, "Dbl.", 0.35);
+                    if (view.canSurrender)
                         write(655 + x, 25 - y, "Surr.", 0.35);
-                    }
                 }
             }
-
-            //Write the player's total
-            // Use string so we can concatenate the message with the total variable
-            string strTotal = to_string(player.getTotal());
-            // Convert the string to const char* type to use in write func
-            const char* charMessage = strTotal.c_str();
-            write(300, 85, "Total:", .25);
-            write(301, 85, "Total:", .25);
-            write(380, 85, charMessage, .25);
-            write(381, 85, charMessage, .25);
-
-            //Write the dealer's total
-            // Use string so we can concatenate the message with the total variable
-            strTotal = to_string(dealer.getTotal());
-            // Convert the string to const char* type to use in write func
-            charMessage = strTotal.c_str();
-            write(300, 565, "Total:", .25);
-            write(301, 565, "Total:", .25);
-            if (!player.getTurnOver())
-            {
-                write(380, 565, "...", .25);
-                write(381, 565, "...", .25);
-            }
-            else
-            {
-                write(380, 565, charMessage, .25);
-                write(381, 565, charMessage, .25);
-            }
-
             glEnable(GL_BLEND);
-            // Cover the dealer's second card with a card back so it appears face down
-            if (!player.getTurnOver())
-            {
-                cardBack.draw(dealer.getDrawX() + cardBack.getWidth() / 2, dealer.getDrawY());
-            }
-            else
+
+            if (showHint)
             {
-                // If player didn't  bust, dealer takes turn
-                if (!player.getBusted())
-                    dealer.takeTurn(deck);
-                // If player did bust, dealer turn is over
-                else
-                {
-                    dealer.setTurnOver(true);
-                }
-                roundOver = true;
-                // The dealer's turn should be over by now
-                // Calculate and print out both hands
-                int playerTotal = player.getTotal();
-                int dealerTotal = dealer.getTotal();
-                bool dealerBJ = false;
-                if (dealerTotal == 21 && dealer.hand.size() == 2)
-                    dealerBJ = true;
-
-                //cout << "Your total: " << playerTotal << endl;
-                //cout << "Dealer's total: " << dealerTotal << endl << endl;
-                // If the round is over, see who wins
-                int winnings = 0;
-                if (roundOver)
-                {
-                    // Player wins (player total more than dealer's while not busted, or player doesn't bust and dealer does
-                    if ((playerTotal > dealerTotal && !player.getBusted()) || !player.getBusted() && dealer.getBusted())
-                    {
-                        // Player blackjack
-                        if (playerTotal == 21 && player.hand.size() == 2 && !dealerBJ)
-                        {
-                            cout << "Blackjack! You win big!" << endl;
-                            // 3:2 payout
-                            winnings = player.getBet() + player.getBet() * 1.5;
-                            player.setBal(player.getBal() + winnings);
-                            player.displayWinnings(player.getBet() + player.getBet() * 1.5);
-                            // Start new round sequence
-                            winCase = 1;
-                            newRound(winnings, 1);
-                        }
-                        // Regular win
-                        else
-                        {
-                            cout << "You win!" << endl;
-                            // 1:1 payout
-                            winnings = player.getBet() * 2;
-                            player.setBal(player.getBal() + winnings);
-                            player.displayWinnings(player.getBet() * 2);
-                            // Start new round sequence
-                            winCase = 2;
-                            newRound(winnings, 2);
-                        }
-                    }
-                    // Player loses and does not receive their bet back (dealer didn't bust)
-                    else if (playerTotal < dealerTotal && !dealer.getBusted() || player.getBusted())
-                    {
-                        cout << "You lose!" << endl;
-                        cout << "Your new balance: " << player.getBal() << endl;
-                        if (player.getBal() == 0)
-                        {
-                            gameOver = true;
-                            cout << "gameover";
-                        }
-
-                        // Start new round sequence
-                        winCase = 3;
-                        newRound(winnings, 3);
-                    }
-                    // Tie, player receives their bet back (as long as no one busted)
-                    else if (playerTotal == dealerTotal && !dealer.getBusted() && !player.getBusted())
-                    {
-                        // If both the dealer and the player got blackjack
-                        if ((player.hand.size() == 2 && playerTotal == 21 && dealerBJ) || playerTotal != 21)
-                        {
-                            cout << "Push!" << endl;
-                            player.setBal(player.getBal() + player.getBet());
-                            cout << "Your new balance: " << player.getBal() << endl;
-                            // Start new round sequence
-                            winCase = 4;
-                            newRound(winnings, 4);
-                        }
-                    }
-                    //// Start new round sequence (error)
-                    //newRound(winnings, 5);
-                }
+                static const char* const names[] = { "", "Hit", "Stand", "Double", "Surrender" };
+                Advice a = advisor->advise(view);
+                char hint[48];
+                snprintf(hint, sizeof(hint), "Hint: %s %+.3f", names[static_cast<int>(a.best)], a.bestValue);
+                glDisable(GL_BLEND);
+                write(230, 130, hint, 0.14);
+                glEnable(GL_BLEND);
             }
         }
         else
@@ -503,6 +559,13 @@ void display_func(void)
             glEnable(GL_BLEND);
         }
 
+        if (view.playerCount > 0)
+        {
+            glDisable(GL_BLEND);
+            drawTotals();
+            glEnable(GL_BLEND);
+        }
+
         // Draw all of the chips
         half.draw();
         one.draw();
@@ -533,22 +596,20 @@ void display_func(void)
         write(writeX + 1, 250, "Bal:");
         write(writeX + 50, 250, "$");
         write(writeX + 51, 250, "$");
-        writeFloat(writeX + 67, 250, player.getBal(), 2);
-        writeFloat(writeX + 68, 250, player.getBal(), 2);
+        writeFloat(writeX + 67, 250, view.bal, 2);
+        writeFloat(writeX + 68, 250, view.bal, 2);
         write(writeX, 200, "Bet:");
         write(writeX + 1, 200, "Bet:");
         write(writeX + 50, 200, "$");
         write(writeX + 51, 200, "$");
-        writeFloat(writeX + 67, 200, player.getBet(), 2);
-        writeFloat(writeX + 68, 200, player.getBet(), 2);
+        writeFloat(writeX + 67, 200, view.bet, 2);
+        writeFloat(writeX + 68, 200, view.bet, 2);
 
 
-        // First, draw end screen
-        switch (winCase)
+        // First, draw end screen (once the last card has been dealt out)
+        switch (animator.isIdle() ? view.result : RoundResult::None)
         {
-        case 1:
-            glEnable(GL_BLEND);
-            glDisable(GL_BLEND);
+        case RoundResult::Blackjack:
             // triple bold
             for (int x = 0; x < 3; x++)
             {
@@ -558,10 +619,8 @@ void display_func(void)
                 }
             }
             break;
-        case 2:
+        case RoundResult::Win:
             writeX = 312;
-            glEnable(GL_BLEND);
-            glDisable(GL_BLEND);
             for (int x = 0; x < 3; x++)
             {
                 for (int y = 0; y < 3; y++)
@@ -571,12 +630,8 @@ void display_func(void)
                 }
             }
             break;
-        case 3:
+        case RoundResult::Loss:
             writeX = 315;
-            glEnable(GL_BLEND);
-            //endScreen.setVisible(true);
-            //endScreen.draw(50, 100, textures[62]);
-            glDisable(GL_BLEND);
             for (int x = 0; x < 3; x++)
             {
                 for (int y = 0; y < 3; y++)
@@ -586,12 +641,8 @@ void display_func(void)
                 }
             }
             break;
-        case 4:
+        case RoundResult::Push:
             writeX = 330;
-            glEnable(GL_BLEND);
-            //endScreen.setVisible(true);
-            //endScreen.draw(50, 100, textures[62]);
-            glDisable(GL_BLEND);
             for (int x = 0; x < 3; x++)
             {
                 for (int y = 0; y < 3; y++)
@@ -600,14 +651,41 @@ void display_func(void)
                 }
             }
             break;
+        case RoundResult::Surrender:
+            writeX = 305;
+            for (int x = 0; x < 3; x++)
+            {
+                for (int y = 0; y < 3; y++)
+                {
+                    write(writeX + x, 320 - y, "Surrendered", 0.3);
+                }
+            }
+            break;
+        default:
+            break;
         }
 
         glEnable(GL_BLEND);
 
     }
 
-    glFlush();
-    glutPostRedisplay();
+    if (showFrameStats)
+    {
+        glDisable(GL_BLEND);
+        drawFrameStats();
+        glEnable(GL_BLEND);
+    }
+
+    frameStats.endCpu();
+    frameStats.endGpu();
+    glutSwapBuffers();
+
+    // Only keep one pending frame, window events can call display_func on their own
+    if (!redisplayPending)
+    {
+        redisplayPending = true;
+        glutTimerFunc(framePacer.msUntilNextFrame(), timer_func, 0);
+    }
 }
 
 // Exit program using the escape key
@@ -615,124 +693,586 @@ void keyboard_func(unsigned char c, int x, int y)
 {
     switch (c)
     {
-        // Esc: exit
+        // Esc: exit, exporting the frame times first
     case 27:
+        // Let the session finish before the globals holding it go away
+        human.close();
+        sessionPool->wait();
+        if (frameStats.getCpu().getCount() > 0)
+        {
+            frameStats.printSummary();
+            frameStats.writeCsv("frame_times.csv");
+        }
         exit(0);
         break;
+        // F: toggle the frame time overlay (and GPU timing along with it)
+    case 'f':
+    case 'F':
+        showFrameStats = !showFrameStats;
+        frameStats.setGpuTiming(showFrameStats);
+        break;
+        // H: toggle the best action hint next to the buttons
+    case 'h':
+    case 'H':
+        if (!advisor)
+            advisor.reset(new Advisor(session->getTable().getRules()));
+        showHint = !showHint;
+        break;
     }
 }
 
+// Slide a chip from the rack to the bet and queue the bet itself
+void placeChip(const Chip& chip, float amount)
+{
+    // If the player has the money
+    if (view.bal >= amount)
+        animator.moveChip(chip.getTexture(), chip.getWidth(), chip.getHeight(), chip.getLeft(), chip.getTop(), BET_X, BET_Y);
+    human.post({ CommandType::AddChip, amount });
+}
+
+// Clicks only post commands; the session applies them on its thread
 void mouse_func(int button, int state, int x, int y)
 {
-    // If right mouse button clicked..
+    // If left mouse button clicked..
     if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN)
     {
-        if (gameOver)
+        if (view.gameOver)
         {
             return;
         }
-        //if (endScreen.checkClick(x, CANVAS_HEIGHT - y))
-            //background.draw()
-        // As long as the player's turn isn't over, they should be able to do any of the following:
-        if (!player.getTurnOver() && !gameOver)
+        int clickY = CANVAS_HEIGHT - y;
+        // Player may only bet and start the deal if the round hasn't started yet
+        if (view.state == RoundState::Betting)
+        {
+            // If it clicks on a chip, add the chip to the bet
+            if (half.checkClick(x, clickY))
+                placeChip(half, 0.5);
+            else if (one.checkClick(x, clickY))
+                placeChip(one, 1.0);
+            else if (five.checkClick(x, clickY))
+                placeChip(five, 5.0);
+            else if (twentyfive.checkClick(x, clickY))
+                placeChip(twentyfive, 25.0);
+            else if (onehundred.checkClick(x, clickY))
+                placeChip(onehundred, 100.0);
+            else if (fivehundred.checkClick(x, clickY))
+                placeChip(fivehundred, 500.0);
+            // NOTE: this will appeaer as "Deal" button before the round has started
+            else if (hit.checkClick(x, clickY))
+                human.post({ CommandType::Deal });
+        }
+        // These are actions that can only be taken after the round has started
+        else if (view.state == RoundState::PlayerTurn)
+        {
+            if (hit.checkClick(x, clickY))
+                human.post({ CommandType::Hit });
+            // Stand button
+            else if (stand.checkClick(x, clickY))
+                human.post({ CommandType::Stand });
+            // Double down and surrender: have to be at initial deal
+            else if (doubleDown.checkClick(x, clickY) && view.canDouble)
+                human.post({ CommandType::DoubleDown });
+            else if (surrender.checkClick(x, clickY) && view.canSurrender)
+                human.post({ CommandType::Surrender });
+        }
+        else if (view.state == RoundState::Insurance)
+        {
+            if (hit.checkClick(x, clickY) && view.canInsure)
+                human.post({ CommandType::Insurance });
+            else if (stand.checkClick(x, clickY))
+                human.post({ CommandType::DeclineInsurance });
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // Headless mode: BlackjackSim --sim <rounds> [--csm], --csm deals from a continuous shuffling machine
+    if (argc >= 3 && strcmp(argv[1], "--sim") == 0)
+    {
+        Simulator sim;
+        if (argc >= 4 && strcmp(argv[3], "--csm") == 0)
+            sim.getDeck().setContinuous(true);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SimResult result = sim.run(strtoull(argv[2], nullptr, 10));
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.print();
+        printf("%.0f rounds/s\n", result.rounds / seconds);
+        sim.getTable().getSideBets().print();
+        reportProfile("profile.folded");
+        return 0;
+    }
+    // Shoe pipeline: BlackjackSim --pregen <shoes> [threads] [producers] [decks] plays the same shoes with
+    // workers that shuffle for themselves, then fed by producer threads that shuffle ahead of them
+    if (argc >= 3 && strcmp(argv[1], "--pregen") == 0)
+    {
+        uint64_t shoes = strtoull(argv[2], nullptr, 10);
+        int threads = argc >= 4 ? std::max(1, atoi(argv[3])) : 1;
+        int producers = argc >= 5 ? std::max(1, atoi(argv[4])) : 1;
+        Rules rules;
+        rules.decks = argc >= 6 ? std::max(1, std::min(8, atoi(argv[5]))) : 8;
+        uint64_t seed = std::random_device{}();
+
+        std::vector<uint8_t> types(52 * rules.decks);
+        Xoshiro256 rng;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint64_t n = 0; n < shoes; n++)
+            shuffleShoe(seed, n, ShoeSampling::Independent, rules.decks, types.data(), rng);
+        double shuffling = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("Shuffling alone: %.0f shoes/s (%d decks)\n", shoes / shuffling, rules.decks);
+
+        WorkStealingPool pool(threads, 4);
+        start = std::chrono::steady_clock::now();
+        SimResult own = runShoes(pool, 0, shoes, seed, nullptr, rules);
+        double ownSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("Workers shuffle:  %.0f rounds/s  edge %.4f%%\n", own.rounds / ownSeconds, own.getEdge() * 100.0);
+
+        start = std::chrono::steady_clock::now();
+        ShoePipeline pipeline(seed, ShoeSampling::Independent, rules.decks, 0, shoes, producers);
+        SimResult fed = runShoes(pipeline, threads, nullptr, rules);
+        double fedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("Pipeline fed:     %.0f rounds/s  edge %.4f%%  (workers waited %llu times, producers %llu)\n",
+            fed.rounds / fedSeconds, fed.getEdge() * 100.0, static_cast<unsigned long long>(pipeline.getConsumerStalls()),
+            static_cast<unsigned long long>(pipeline.getProducerStalls()));
+        printf("Same rounds and net: %s\n", own.rounds == fed.rounds && own.net == fed.net ? "yes" : "NO");
+        return 0;
+    }
+    // Side bets: BlackjackSim --sidebets [decks] [shoes] prints the exact odds of every side bet off the
+    // top of the shoe, then how their exact EV moves round by round through `shoes` simulated shoes
+    if (argc >= 2 && strcmp(argv[1], "--sidebets") == 0)
+    {
+        Rules rules;
+        rules.decks = argc >= 3 ? std::max(1, std::min(8, atoi(argv[2]))) : 6;
+        uint64_t shoes = argc >= 4 ? strtoull(argv[3], nullptr, 10) : 100;
+        Simulator sim;
+        sim.setRules(rules);
+        sim.getDeck().setShoeSequence(std::random_device{}(), ShoeSampling::Independent);
+        int counts[CARD_TYPES];
+        shoeComposition(sim.getDeck(), counts);
+
+        auto printOdds = [&](auto bet) {
+            using Bet = decltype(bet);
+            std::array<double, Bet::OUTCOMES> odds = sideBetOdds<Bet>(counts);
+            printf("%s, %d deck(s): EV %+.3f%%\n", Bet::name(), rules.decks, sideBetEV<Bet>(counts) * 100.0);
+            for (int o = Bet::OUTCOMES - 1; o > 0; o--)
+                printf("  %-42s %5d:1  %.6f\n", Bet::outcomeName(o), Bet::pays(o), odds[o]);
+        };
+        printOdds(PerfectPairs());
+        printOdds(TwentyOnePlusThree());
+        printOdds(LuckyLadies());
+
+        // The exact EV before every deal, from the cards left in the shoe
+        double best[3] = { -1, -1, -1 };
+        uint64_t positive[3] = {}, rounds = 0;
+        SimResult stats;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint64_t shoe = 0; shoe < shoes; shoe++)
         {
-            // Player may only bet and start the deal if the round hasn't started yet
-            if (!roundStarted)
+            sim.getDeck().startShoe(shoe);
+            do
             {
-                // If it clicks on a chip, set the bet to the appropriate amount and take away from the balance
-                if (half.checkClick(x, CANVAS_HEIGHT - y))
-                {
-                    // If the player has the money
-                    if (player.getBal() >= 0.5)
-                    {
-                        player.setBet(player.getBet() + 0.5);
-                        player.setBal(player.getBal() - 0.5);
-                    }
-                }
-                else if (one.checkClick(x, CANVAS_HEIGHT - y))
-                {
-                    if (player.getBal() >= 1.0)
-                    {
-                        player.setBet(player.getBet() + 1.0);
-                        player.setBal(player.getBal() - 1.0);
-                    }
-                }
-                else if (five.checkClick(x, CANVAS_HEIGHT - y))
-                {
-                    if (player.getBal() >= 5.0)
-                    {
-                        player.setBet(player.getBet() + 5.0);
-                        player.setBal(player.getBal() - 5.0);
-                    }
-                }
-                else if (twentyfive.checkClick(x, CANVAS_HEIGHT - y))
+                shoeComposition(sim.getDeck(), counts);
+                double ev[3] = { sideBetEV<PerfectPairs>(counts), sideBetEV<TwentyOnePlusThree>(counts),
+                    sideBetEV<LuckyLadies>(counts) };
+                for (int b = 0; b < 3; b++)
                 {
-                    if (player.getBal() >= 25.0)
-                    {
-                        player.setBet(player.getBet() + 25.0);
-                        player.setBal(player.getBal() - 25.0);
-                    }
+                    best[b] = std::max(best[b], ev[b]);
+                    positive[b] += ev[b] > 0;
                 }
-                else if (onehundred.checkClick(x, CANVAS_HEIGHT - y))
-                {
-                    if (player.getBal() >= 100.0)
-                    {
-                        player.setBet(player.getBet() + 100.0);
-                        player.setBal(player.getBal() - 100.0);
-                    }
-                }
-                else if (fivehundred.checkClick(x, CANVAS_HEIGHT - y))
-                {
-                    if (player.getBal() >= 500.0)
-                    {
-                        player.setBet(player.getBet() + 500.0);
-                        player.setBal(player.getBal() - 500.0);
-                    }
-                }
-                // NOTE: this will appeaer as "Deal" button before the round has started
-                else if (hit.checkClick(x, CANVAS_HEIGHT - y) && player.getBet() > 0)
-                {
-					player.resetHand();
-                    dealer.resetHand();
-                    roundStarted = true;
-                }
-            }
-            // These are actions that can only be taken after the round has started
-            else 
+                rounds++;
+                sim.playRound(stats);
+            } while (!sim.getTable().needsShuffle());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("\nOver %llu rounds of %llu shoes (%.1f us per round for all three):\n",
+            static_cast<unsigned long long>(rounds), static_cast<unsigned long long>(shoes), seconds * 1e6 / std::max<uint64_t>(rounds, 1));
+        const char* names[3] = { PerfectPairs::name(), TwentyOnePlusThree::name(), LuckyLadies::name() };
+        for (int b = 0; b < 3; b++)
+            printf("  %-14s best EV %+.3f%%, positive before %.2f%% of rounds\n", names[b], best[b] * 100.0,
+                100.0 * positive[b] / std::max<uint64_t>(rounds, 1));
+        return 0;
+    }
+    // Parallel mode: BlackjackSim --shoes <shoes> [threads] [--pin] plays whole shoes on the work-stealing
+    // pool; --pin places the workers node by node
+    if (argc >= 3 && strcmp(argv[1], "--shoes") == 0)
+    {
+        WorkStealingPool pool(argc >= 4 ? atoi(argv[3]) : 0, 4);
+        NumaTopology topology = NumaTopology::detect();
+        if (argc >= 5 && strcmp(argv[4], "--pin") == 0)
+            pool.setTopology(topology);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SimResult result = runShoes(pool, 0, strtoull(argv[2], nullptr, 10), std::random_device{}());
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.print();
+        printf("%.0f rounds/s on %d threads\n", result.rounds / seconds, pool.getThreads());
+        for (size_t w = 0; w < pool.getStats().size(); w++)
+        {
+            const WorkerStats& s = pool.getStats()[w];
+            printf("  worker %2zu (node %d%s): %8llu shoes  %6llu pieces  %6llu splits  %5llu steals (%llu cross-node)  %7llu failed\n",
+                w, s.node, s.pinned ? ", pinned" : "", static_cast<unsigned long long>(s.items),
+                static_cast<unsigned long long>(s.tasks), static_cast<unsigned long long>(s.splits),
+                static_cast<unsigned long long>(s.steals), static_cast<unsigned long long>(s.remoteSteals),
+                static_cast<unsigned long long>(s.failedSteals));
+        }
+        printf("%d NUMA node(s)\n", topology.getNodes());
+        reportProfile("profile.folded");
+        return 0;
+    }
+    // Allocation check: BlackjackSim --alloc <rounds> counts heap allocations per round once the engine is warm
+    if (argc >= 3 && strcmp(argv[1], "--alloc") == 0)
+    {
+        Simulator sim;
+        SimResult stats;
+        for (int i = 0; i < 100000; i++)
+            sim.playRound(stats);
+        uint64_t rounds = strtoull(argv[2], nullptr, 10);
+        uint64_t before = heapAllocations();
+        for (uint64_t i = 0; i < rounds; i++)
+            sim.playRound(stats);
+        uint64_t allocations = heapAllocations() - before;
+        printf("%llu heap allocations in %llu rounds (%.4f per round)\n", static_cast<unsigned long long>(allocations),
+            static_cast<unsigned long long>(rounds), rounds > 0 ? static_cast<double>(allocations) / rounds : 0.0);
+        return 0;
+    }
+    // Batch mode: BlackjackSim --batch <rounds> plays the same game on the SIMD lockstep engine
+    if (argc >= 3 && strcmp(argv[1], "--batch") == 0)
+    {
+        static BatchSimulator<4> batch(std::random_device{}());
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SimResult result = batch.run(strtoull(argv[2], nullptr, 10));
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.print();
+        printf("%.0f rounds/s (%d lanes)\n", result.rounds / seconds, BatchSimulator<4>::LANES);
+        return 0;
+    }
+    // Bankroll mode: BlackjackSim --bankroll <sessions> [bankroll unit stopLoss winGoal rounds]
+    if (argc >= 3 && strcmp(argv[1], "--bankroll") == 0)
+    {
+        BankrollSettings settings;
+        settings.sessions = strtoull(argv[2], nullptr, 10);
+        if (argc >= 4) settings.bankroll = static_cast<float>(atof(argv[3]));
+        if (argc >= 5) settings.unit = static_cast<float>(atof(argv[4]));
+        if (argc >= 6) settings.stopLoss = static_cast<float>(atof(argv[5]));
+        if (argc >= 7) settings.winGoal = static_cast<float>(atof(argv[6]));
+        if (argc >= 8) settings.maxRounds = strtoull(argv[7], nullptr, 10);
+        settings.checkpointRounds = std::max<uint64_t>(settings.maxRounds / 10, 1);
+        Simulator sim;
+        BankrollSimulator bankroll(settings);
+        bankroll.run(sim);
+        bankroll.print();
+        return 0;
+    }
+    // Regression check: BlackjackSim --replay record <file> [rounds] writes the golden digests of the fixed
+    // scenarios, --replay check <file> [slowdown%] replays them and fails on any difference or a slower build
+    if (argc >= 4 && strcmp(argv[1], "--replay") == 0)
+    {
+        bool record = strcmp(argv[2], "record") == 0;
+        if (record)
+        {
+            ReplayRun run = recordReplay(argc >= 5 ? std::max(1ull, strtoull(argv[4], nullptr, 10)) : 100000);
+            bool ok = saveReplay(argv[3], run);
+            printf("%llu rounds of %zu scenarios at %.0f hands/s\n", static_cast<unsigned long long>(run.rounds),
+                run.digests.size(), run.handsPerSecond);
+            printf(ok ? "Wrote %s\n" : "Failed writing %s\n", argv[3]);
+            return ok ? 0 : 1;
+        }
+        ReplayRun golden;
+        if (!loadReplay(argv[3], golden))
+        {
+            printf("Can't read %s\n", argv[3]);
+            return 1;
+        }
+        double slowdown = argc >= 5 ? atof(argv[4]) / 100.0 : 0.1;
+        bool ok = checkReplay(golden, recordReplay(golden.rounds), slowdown);
+        printf(ok ? "PASS\n" : "FAIL\n");
+        return ok ? 0 : 1;
+    }
+    // Sessions: BlackjackSim --sessions <count> [threads] [rounds] plays that many tables at once as coroutines on a
+    // thread pool, a quarter each basic strategy bots, counting bots, scripted players and clicks from another thread
+    if (argc >= 3 && strcmp(argv[1], "--sessions") == 0)
+    {
+        size_t count = static_cast<size_t>(std::max(1ull, strtoull(argv[2], nullptr, 10)));
+        int threads = argc >= 4 ? std::max(1, atoi(argv[3])) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        uint64_t rounds = argc >= 5 ? strtoull(argv[4], nullptr, 10) : 1000;
+        CountStrategy counter;
+        const float ramp[BET_RAMP_SIZE] = { 1, 1, 2, 4, 6, 8 };
+        std::copy(ramp, ramp + BET_RAMP_SIZE, counter.ramp);
+        counter.deviations = illustriousDeviations();
+        std::vector<Command> script;
+        for (uint64_t i = 0; i < rounds; i++)
+        {
+            script.push_back({ CommandType::AddChip, 1.0f });
+            script.push_back({ CommandType::Deal });
+            script.push_back({ CommandType::DeclineInsurance });
+            script.push_back({ CommandType::Stand });
+        }
+
+        Rules rules;
+        rules.decks = 6;
+        SessionPool pool(threads);
+        std::vector<std::unique_ptr<CommandSource>> sources;
+        std::vector<HumanSource*> humans;
+        std::vector<std::unique_ptr<Session>> sessions;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i % 4 == 0)
+                sources.emplace_back(new BotSource());
+            else if (i % 4 == 1)
+                sources.emplace_back(new BotSource(&counter));
+            else if (i % 4 == 2)
+                sources.emplace_back(new ScriptedSource(script));
+            else
             {
-                if (hit.checkClick(x, CANVAS_HEIGHT - y))
-                {
-                    player.takeAction(deck, 1);
-                }
-                // Stand button
-                else if (stand.checkClick(x, CANVAS_HEIGHT - y))
-                {
-                    player.takeAction(deck, 2);
-                }
-                // Double down and surrender: have to be at initial deal
-                else if (doubleDown.checkClick(x, CANVAS_HEIGHT - y) && player.hand.size() == 2)
-                {
-                    player.takeAction(deck, 3);
-                }
-                else if (surrender.checkClick(x, CANVAS_HEIGHT - y) && player.hand.size() == 2)
+                humans.push_back(new HumanSource());
+                sources.emplace_back(humans.back());
+            }
+            sessions.emplace_back(new Session(*sources.back(), pool, rules));
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (std::unique_ptr<Session>& session : sessions)
+            session->start(1000.0f, rounds);
+        // Stands in for the people at the human tables: click basic strategy for whoever is waiting
+        uint64_t clicks = 0;
+        TableSnapshot waitingOn;
+        while (pool.getLive() > 0)
+        {
+            for (HumanSource* human : humans)
+                if (human->waiting(waitingOn))
                 {
-                    player.takeAction(deck, 4);
+                    human->post(strategyCommand(waitingOn, nullptr, 1.0f));
+                    clicks++;
                 }
+            std::this_thread::yield();
+        }
+        pool.wait();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-            }
+        const char* const kinds[] = { "Basic strategy bots", "Counting bots", "Scripted", "Human" };
+        SimResult all;
+        for (int k = 0; k < 4; k++)
+        {
+            SimResult kind;
+            for (size_t i = k; i < count; i += 4)
+                kind.add(sessions[i]->getStats());
+            all.add(kind);
+            printf("%s: ", kinds[k]);
+            kind.print();
         }
+        printf("%zu sessions on %d threads: %llu rounds in %.2fs, %.0f rounds/s\n", count, pool.getThreads(),
+            static_cast<unsigned long long>(all.rounds), seconds, all.rounds / seconds);
+        printf("%llu resumes, %llu clicks posted\n", static_cast<unsigned long long>(pool.getResumes()),
+            static_cast<unsigned long long>(clicks));
+        return 0;
+    }
+    // Export mode: BlackjackSim --export <rounds> <file> writes every round to a columnar file
+    if (argc >= 4 && strcmp(argv[1], "--export") == 0)
+    {
+        HandExporter exporter;
+        if (!exporter.open(argv[3]))
+        {
+            printf("Can't open %s\n", argv[3]);
+            return 1;
+        }
+        Simulator sim;
+        sim.setRecorder([&exporter](const HandRecord& r) { exporter.add(r); });
+        SimResult result = sim.run(strtoull(argv[2], nullptr, 10));
+        bool ok = exporter.close();
+        result.print();
+        printf(ok ? "Wrote %s\n" : "Failed writing %s\n", argv[3]);
+        return ok ? 0 : 1;
+    }
+    // Worker process for --distribute: BlackjackSim --worker <port> [threads]
+    if (argc >= 3 && strcmp(argv[1], "--worker") == 0)
+        return runClusterWorker(atoi(argv[2]), argc >= 4 ? atoi(argv[3]) : 1);
+    // Distributed mode: BlackjackSim --distribute <shoes> <processes> [threads seed shardShoes] runs the shoes
+    // on worker processes and merges their results
+    if (argc >= 4 && strcmp(argv[1], "--distribute") == 0)
+    {
+        ClusterSettings settings;
+        settings.shoes = strtoull(argv[2], nullptr, 10);
+        settings.processes = std::max(1, atoi(argv[3]));
+        if (argc >= 5) settings.threadsPerProcess = atoi(argv[4]);
+        settings.seed = argc >= 6 ? strtoull(argv[5], nullptr, 10) : std::random_device{}();
+        if (argc >= 7) settings.shardShoes = strtoull(argv[6], nullptr, 10);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Coordinator coordinator(settings, argv[0]);
+        SimResult result;
+        if (!coordinator.run(result))
+        {
+            printf("The workers stopped before the job finished\n");
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.print();
+        printf("%.0f rounds/s on %d processes, seed %llu, %llu shards resubmitted, %d workers replaced\n",
+            result.rounds / seconds, settings.processes, static_cast<unsigned long long>(settings.seed),
+            static_cast<unsigned long long>(coordinator.getResubmitted()), coordinator.getRespawns());
+        return 0;
+    }
+    // Server mode: BlackjackSim --serve [port] [threads] runs jobs sent to 127.0.0.1:port until "shutdown"
+    if (argc >= 2 && strcmp(argv[1], "--serve") == 0)
+    {
+        JobServer server(argc >= 3 ? atoi(argv[2]) : 5817, argc >= 4 ? atoi(argv[3]) : 0);
+        if (!server.start())
+        {
+            printf("Can't listen on port %d\n", server.getPort());
+            return 1;
+        }
+        printf("Listening on 127.0.0.1:%d with %d workers\n", server.getPort(), server.getThreads());
+        fflush(stdout);
+        server.run();
+        return 0;
+    }
+    // Exact mode: BlackjackSim --exact [decks] works out the basic strategy edge off the top of the shoe
+    if (argc >= 2 && strcmp(argv[1], "--exact") == 0)
+    {
+        Rules rules;
+        if (argc >= 3)
+            rules.decks = atoi(argv[2]);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double ev = ExactCalculator(rules).run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%d deck(s): player edge %.5f%% (exact, %.1f s)\n", rules.decks, ev * 100.0, seconds);
+        return 0;
+    }
+    // Advisor latency: BlackjackSim --advise <queries> [exact] times the advisor on decisions from real rounds,
+    // the table estimate on all of them and the exact answer (asked twice in a row) on the first `exact`
+    if (argc >= 3 && strcmp(argv[1], "--advise") == 0)
+    {
+        Simulator sim;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Advisor advisor(sim.getTable().getRules());
+        printf("Built tables in %.2f s\n", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        // Collect decisions first so the timings only cover the advisor
+        std::vector<TableSnapshot> decisions;
+        size_t queries = std::max<size_t>(strtoull(argv[2], nullptr, 10), 1);
+        size_t exact = std::min<size_t>(argc >= 4 ? strtoull(argv[3], nullptr, 10) : 1000, queries);
+        while (decisions.size() < queries)
+        {
+            sim.dealRound();
+            if (sim.getTable().getSnapshot().state == RoundState::PlayerTurn)
+                decisions.push_back(sim.getTable().getSnapshot());
+            sim.finishRound();
+        }
+
+        auto microseconds = [](std::chrono::steady_clock::time_point t) {
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t).count();
+        };
+        auto report = [](const char* label, std::vector<double>& times) {
+            if (times.empty())
+                return;
+            std::sort(times.begin(), times.end());
+            printf("%-14s p50 %9.3f us  p99 %9.3f us  max %10.1f us\n", label, times[times.size() / 2],
+                times[times.size() * 99 / 100], times.back());
+        };
+        std::vector<double> table, cold, warm;
+        std::vector<Action> estimated;
+        for (const TableSnapshot& s : decisions)
+        {
+            std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+            Action best = advisor.advise(s).best;
+            table.push_back(microseconds(t));
+            estimated.push_back(best);
+        }
+        size_t agree = 0;
+        for (size_t i = 0; i < exact; i++)
+        {
+            std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+            Action best = advisor.adviseExact(decisions[i]).best;
+            cold.push_back(microseconds(t));
+            t = std::chrono::steady_clock::now();
+            advisor.adviseExact(decisions[i]);
+            warm.push_back(microseconds(t));
+            agree += best == estimated[i] ? 1 : 0;
+        }
+        report("Table", table);
+        report("Exact, first", cold);
+        report("Exact, again", warm);
+        if (exact > 0)
+            printf("Table agrees with the exact best action on %.2f%% of %llu decisions\n", agree * 100.0 / exact,
+                static_cast<unsigned long long>(exact));
+        return 0;
+    }
+    // Compare: BlackjackSim --compare <shoes> [antithetic|stratified] plays basic strategy and the
+    // Illustrious 18 indices (both flat bet) on the same shoes
+    if (argc >= 3 && strcmp(argv[1], "--compare") == 0)
+    {
+        ShoeSampling sampling = ShoeSampling::Independent;
+        if (argc >= 4 && strcmp(argv[3], "antithetic") == 0)
+            sampling = ShoeSampling::Antithetic;
+        else if (argc >= 4 && strcmp(argv[3], "stratified") == 0)
+            sampling = ShoeSampling::Stratified;
+        CountStrategy indices;
+        indices.deviations = illustriousDeviations();
+        Comparison c = compareStrategies(nullptr, &indices, strtoull(argv[2], nullptr, 10), std::random_device{}(), sampling);
+        printf("Basic strategy edge %.3f%%, with indices %.3f%%\n", c.a.getEdge() * 100.0, c.b.getEdge() * 100.0);
+        printf("Difference %+.4f%% +/- %.4f%% per round over %llu blocks\n", c.diffPerRound * 100.0, c.stdErr * 100.0,
+            static_cast<unsigned long long>(c.blocks));
+        printf("Variance reduction from common shoes: %.1fx\n", c.varianceReduction);
+        return 0;
+    }
+    // Optimizer: BlackjackSim --optimize <generations> tunes a Hi-Lo bet ramp and the Illustrious 18 indices
+    if (argc >= 3 && strcmp(argv[1], "--optimize") == 0)
+    {
+        CountStrategy start;
+        const float ramp[BET_RAMP_SIZE] = { 1, 1, 2, 4, 6, 8 };
+        std::copy(ramp, ramp + BET_RAMP_SIZE, start.ramp);
+        start.deviations = illustriousDeviations();
+        StrategyOptimizer optimizer(OptimizerSettings(), std::random_device{}());
+        printf("Start: ");
+        StrategyOptimizer::printStrategy(start);
+        CountStrategy best = optimizer.run(start, atoi(argv[2]));
+
+        Simulator sim;
+        sim.setStrategy(&best);
+        SimResult result = sim.run(1000000);
+        printf("Best: ");
+        StrategyOptimizer::printStrategy(best);
+        result.print();
+        printf("Score (EV / SD per round): %.4f\n", result.getScore());
+        reportProfile("profile.folded");
+        return 0;
+    }
+    // What-if mode: BlackjackSim --whatif <rollouts> deals one hand and estimates every action from it
+    if (argc >= 3 && strcmp(argv[1], "--whatif") == 0)
+    {
+        Simulator sim;
+        sim.dealRound();
+        // A natural settles on the deal, so deal until there is a decision to make
+        while (sim.getTable().getSnapshot().state != RoundState::PlayerTurn)
+            sim.dealRound();
+        const TableSnapshot& s = sim.getTable().getSnapshot();
+        std::cout << "Player's hand (total " << s.playerTotal << "):" << std::endl;
+        for (int i = 0; i < s.playerCount; i++)
+            s.playerCards[i].display();
+        std::cout << "Dealer shows:" << std::endl;
+        s.dealerCards[0].display();
+        std::cout << std::endl;
+
+        GameState state;
+        sim.getTable().saveState(state);
+        // Same hex the job server takes in a whatif request
+        std::vector<uint8_t> blob;
+        writeState(state, blob);
+        printf("state=");
+        for (uint8_t b : blob)
+            printf("%02x", b);
+        printf("\n\n");
+        RolloutAnalyzer analyzer;
+        printEstimates(analyzer.estimate(state, atoi(argv[2]), state.round));
+        return 0;
     }
-}
 
-int main(int argc, char** argv)
-{
     glutInit(&argc, argv);                        	 // Initialize GLUT.
-    glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB);     // Set display mode.
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);     // Set display mode.
     glutInitWindowPosition(0, 0);   		         // Set top-left display-window position.
     glutInitWindowSize(CANVAS_WIDTH, CANVAS_HEIGHT);           	     // Set display-window width and height.
     glutCreateWindow("BlackjackSim"); 	 // Create display window.
 
     init();                            		        // Execute initialization procedure.
+    enableVsync();
     glutDisplayFunc(display_func);                  // Send graphics to display window.
     glutMouseFunc(mouse_func);
     glutKeyboardFunc(keyboard_func);
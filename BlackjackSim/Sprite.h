@@ -32,6 +32,8 @@ public:
 	}
 
     GLuint getTexture() const { return texture; }
+    int getLeft() const { return left; }
+    int getTop() const { return top; }
     int getWidth() const { return width; }
     int getHeight() const { return height; }
 
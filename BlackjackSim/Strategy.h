@@ -0,0 +1,167 @@
+/*
+* @file Strategy.h
+* @brief Basic strategy for the headless player.
+*
+* This file defines the `Action` enum (numbered to match Player::takeAction) and the basic
+* strategy tables used when the game is played without a human. Splits are not part of the
+* game, so the tables only cover hard and soft totals. `CountStrategy` layers a Hi-Lo bet ramp
+* and count-based index plays on top of basic strategy.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <vector>
+
+// None is only ever recorded, for a round that settled on the deal with no decision made
+enum class Action
+{
+    None = 0, Hit = 1, Stand = 2, DoubleDown = 3, Surrender = 4
+};
+
+// Table entries: H = hit, S = stand, D = double (else hit), d = double (else stand), R = surrender (else hit)
+// Columns are the dealer's up card: 2 3 4 5 6 7 8 9 10 A
+namespace strategy_tables
+{
+    // Hard totals 5 through 21
+    static const char* const HARD[] = {
+        "HHHHHHHHHH", // 5
+        "HHHHHHHHHH", // 6
+        "HHHHHHHHHH", // 7
+        "HHHHHHHHHH", // 8
+        "HDDDDHHHHH", // 9
+        "DDDDDDDDHH", // 10
+        "DDDDDDDDDH", // 11
+        "HHSSSHHHHH", // 12
+        "SSSSSHHHHH", // 13
+        "SSSSSHHHHH", // 14
+        "SSSSSHHHRH", // 15
+        "SSSSSHHRRR", // 16
+        "SSSSSSSSSS", // 17
+        "SSSSSSSSSS", // 18
+        "SSSSSSSSSS", // 19
+        "SSSSSSSSSS", // 20
+        "SSSSSSSSSS", // 21
+    };
+
+    // Soft totals 13 (A,2) through 21 (A,10)
+    static const char* const SOFT[] = {
+        "HHHDDHHHHH", // 13
+        "HHHDDHHHHH", // 14
+        "HHDDDHHHHH", // 15
+        "HHDDDHHHHH", // 16
+        "HDDDDHHHHH", // 17
+        "SddddSSHHH", // 18
+        "SSSSSSSSSS", // 19
+        "SSSSSSSSSS", // 20
+        "SSSSSSSSSS", // 21
+    };
+}
+
+/*******************************************************************************************
+* Look up the basic strategy play. `upcard` is the dealer's up card value as Card::getValue()
+* reports it (Ace = 1, faces = 10).
+********************************************************************************************/
+inline Action basicStrategy(int total, bool soft, int upcard, bool canDouble, bool canSurrender)
+{
+    if (total >= 21)
+        return Action::Stand;
+    int column = upcard == 1 ? 9 : upcard - 2;
+    char play;
+    if (soft && total >= 13)
+        play = strategy_tables::SOFT[total - 13][column];
+    else if (total >= 5)
+        play = strategy_tables::HARD[total - 5][column];
+    else
+        play = 'H';
+
+    switch (play)
+    {
+    case 'D':
+        return canDouble ? Action::DoubleDown : Action::Hit;
+    case 'd':
+        return canDouble ? Action::DoubleDown : Action::Stand;
+    case 'R':
+        return canSurrender ? Action::Surrender : Action::Hit;
+    case 'S':
+        return Action::Stand;
+    default:
+        return Action::Hit;
+    }
+}
+
+// Play `action` instead of basic strategy when the true count is at or above `index`, or below it
+// if `belowIndex` is set. `upcard` uses Ace = 1 like basicStrategy().
+struct Deviation
+{
+    int total = 0;
+    bool soft = false;
+    int upcard = 0;
+    int index = 0;
+    Action action = Action::Stand;
+    bool belowIndex = false;
+};
+
+// The Illustrious 18 plays that exist in this game (no splits); insurance is CountStrategy::takeInsurance()
+inline std::vector<Deviation> illustriousDeviations()
+{
+    return {
+        { 16, false, 10, 0, Action::Stand, false },
+        { 15, false, 10, 4, Action::Stand, false },
+        { 12, false, 3, 2, Action::Stand, false },
+        { 12, false, 2, 3, Action::Stand, false },
+        { 11, false, 1, 1, Action::DoubleDown, false },
+        { 9, false, 2, 1, Action::DoubleDown, false },
+        { 10, false, 1, 4, Action::DoubleDown, false },
+        { 9, false, 7, 3, Action::DoubleDown, false },
+        { 16, false, 9, 5, Action::Stand, false },
+        { 13, false, 2, -1, Action::Hit, true },
+        { 12, false, 4, 0, Action::Hit, true },
+        { 12, false, 5, -2, Action::Hit, true },
+        { 12, false, 6, -1, Action::Hit, true },
+        { 13, false, 3, -2, Action::Hit, true },
+        { 10, false, 10, 4, Action::DoubleDown, false },
+    };
+}
+
+// The first of the Illustrious 18: insurance, and even money, pay at a true count of +3 or more
+const int INSURANCE_INDEX = 3;
+
+// Bets by true count: ramp[0] at a true count of 0 or less, ramp[i] at i, the last entry above that
+const int BET_RAMP_SIZE = 6;
+
+struct CountStrategy
+{
+    float ramp[BET_RAMP_SIZE] = { 1, 1, 1, 1, 1, 1 };
+    std::vector<Deviation> deviations;
+
+    // Bet in units for a true count
+    float betUnits(double trueCount) const
+    {
+        int i = static_cast<int>(trueCount);
+        return ramp[i <= 0 ? 0 : (i >= BET_RAMP_SIZE ? BET_RAMP_SIZE - 1 : i)];
+    }
+
+    // Basic strategy never insures; a strategy that plays the indices does from INSURANCE_INDEX up
+    bool takeInsurance(double trueCount) const
+    {
+        return !deviations.empty() && trueCount >= INSURANCE_INDEX;
+    }
+
+    // Basic strategy with the first matching deviation applied
+    Action play(int total, bool soft, int upcard, bool canDouble, bool canSurrender, double trueCount) const
+    {
+        for (const Deviation& d : deviations)
+        {
+            if (d.total != total || d.soft != soft || d.upcard != upcard)
+                continue;
+            if (d.belowIndex ? trueCount >= d.index : trueCount < d.index)
+                break;
+            if (d.action == Action::DoubleDown && !canDouble)
+                return Action::Hit;
+            return d.action;
+        }
+        return basicStrategy(total, soft, upcard, canDouble, canSurrender);
+    }
+};
@@ -0,0 +1,490 @@
+/*
+* @file Table.h
+* @brief Round state machine that runs the game for both the window and the headless engine.
+*
+* This file defines the `Table` class, which owns the flow of a round: Betting, Dealing,
+* Insurance, PlayerTurn, DealerTurn and Settle. Insurance (or even money on a natural) is only
+* offered against an Ace. Under a peek the dealer then looks for a natural under an Ace or a ten,
+* and a natural on either side settles the round before the player has anything to decide.
+*
+* Input arrives as `Command`s in a queue and is only applied when update() runs. After every
+* update the table publishes a `TableSnapshot`, a plain copy of everything the renderer needs,
+* so drawing never touches Player, Dealer or Deck.
+*
+* @author Michael Lintelman
+* @date 2026-10-19
+*/
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+// Insurance comes between Dealing and PlayerTurn; it is numbered last so saved states keep their values
+enum class RoundState
+{
+    Betting, Dealing, PlayerTurn, DealerTurn, Settle, Insurance
+};
+
+enum class CommandType
+{
+    AddChip, Deal, Hit, Stand, DoubleDown, Surrender, Insurance, DeclineInsurance
+};
+
+struct Command
+{
+    CommandType type = CommandType::Deal;
+    float amount = 0; // Only used by AddChip
+};
+
+// Numbered to match the old winCase values drawn by the renderer
+enum class RoundResult
+{
+    None = 0, Blackjack = 1, Win = 2, Loss = 3, Push = 4, Surrender = 5
+};
+
+// readState() rejects saved states and results outside these enums
+static_assert(static_cast<int>(RoundState::Insurance) + 1 == ROUND_STATE_COUNT, "ROUND_STATE_COUNT is out of date");
+static_assert(static_cast<int>(RoundResult::Surrender) + 1 == ROUND_RESULT_COUNT, "ROUND_RESULT_COUNT is out of date");
+
+struct TableSnapshot
+{
+    RoundState state = RoundState::Betting;
+    RoundResult result = RoundResult::None;
+    uint32_t round = 0;         // Increments every time a new hand is dealt
+    Card playerCards[MAX_HAND_CARDS];
+    Card dealerCards[MAX_HAND_CARDS];
+    int playerCount = 0;
+    int dealerCount = 0;
+    int playerTotal = 0;
+    int dealerTotal = 0;
+    bool playerSoft = false;
+    bool holeCardHidden = false;
+    bool canDouble = false;
+    bool canSurrender = false;
+    bool canInsure = false;
+    bool evenMoney = false;     // Insuring a natural is taking even money
+    bool gameOver = false;
+    int unseen[RANK_SLOTS] = {};  // Cards the player hasn't seen by rank slot, the hole card included while hidden
+    float bal = 0;
+    float bet = 0;
+    float winnings = 0;         // Paid back to the balance when the round settled
+    float insurance = 0;
+};
+
+class Table
+{
+private:
+    Deck& deck;
+    Player& player;
+    Dealer& dealer;
+    Rules rules;
+    RoundState state = RoundState::Betting;
+    RoundResult result = RoundResult::None;
+    std::vector<Command> commands;     // Drained by update() and reused, so queuing never allocates once warm
+    TableSnapshot snapshot;
+    uint32_t round = 0;
+    float winnings = 0;
+    float insurance = 0;
+    bool evenMoney = false;
+    bool surrendered = false;
+    bool gameOver = false;
+    bool verbose = true;
+    ActiveSideBets sideBets;
+
+    // Apply one command if it is legal in the current state, otherwise drop it
+    void apply(const Command& c)
+    {
+        switch (state)
+        {
+        case RoundState::Betting:
+            if (c.type == CommandType::AddChip && player.getBal() >= c.amount)
+            {
+                player.setBet(player.getBet() + c.amount);
+                player.setBal(player.getBal() - c.amount);
+            }
+            else if (c.type == CommandType::Deal && player.getBet() > 0)
+            {
+                state = RoundState::Dealing;
+            }
+            break;
+        case RoundState::PlayerTurn:
+            if (c.type == CommandType::Hit)
+                player.takeAction(deck, static_cast<int>(Action::Hit));
+            else if (c.type == CommandType::Stand)
+                player.takeAction(deck, static_cast<int>(Action::Stand));
+            else if (c.type == CommandType::DoubleDown && canDouble())
+                player.takeAction(deck, static_cast<int>(Action::DoubleDown));
+            else if (c.type == CommandType::Surrender && canSurrender())
+            {
+                player.takeAction(deck, static_cast<int>(Action::Surrender));
+                surrendered = true;
+            }
+            if (player.getTurnOver())
+                state = RoundState::DealerTurn;
+            break;
+        case RoundState::Insurance:
+            if (c.type == CommandType::Insurance && canInsure())
+            {
+                if (playerNatural())
+                    evenMoney = true;
+                else
+                {
+                    insurance = player.getBet() / 2;
+                    player.setBal(player.getBal() - insurance);
+                }
+            }
+            if (c.type == CommandType::Insurance || c.type == CommandType::DeclineInsurance)
+                state = evenMoney ? RoundState::Settle : afterPeek();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Run the states that don't wait for input
+    void advance()
+    {
+        while (true)
+        {
+            switch (state)
+            {
+            case RoundState::Dealing:
+                deal();
+                state = rules.insuranceOffered && rankSlot(dealer.hand[0]) == 0 ? RoundState::Insurance : afterPeek();
+                break;
+            case RoundState::DealerTurn:
+                // The dealer only draws if the player still has a hand in play
+                if (!player.getBusted() && !surrendered)
+                    dealer.takeTurn(deck);
+                else
+                    dealer.setTurnOver(true);
+                state = RoundState::Settle;
+                break;
+            case RoundState::Settle:
+            {
+                BJ_PROFILE_SCOPE(Phase::Settle);
+                settle();
+                deck.endRound();
+                player.newRound();
+                dealer.newRound();
+                state = RoundState::Betting;
+                break;
+            }
+            default:
+                return;
+            }
+        }
+    }
+
+    // Only an Ace and a ten make 21 in two cards, so only those up cards need a look underneath
+    bool dealerNatural() const
+    {
+        int up = rankSlot(dealer.hand[0]), hole = rankSlot(dealer.hand[1]);
+        return (up == 0 && hole == 9) || (up == 9 && hole == 0);
+    }
+    bool playerNatural() const { return player.hand.size() == 2 && player.getTotal() == 21; }
+
+    // Where the round goes once insurance is out of the way: a natural the table knows about ends it
+    RoundState afterPeek()
+    {
+        if ((rules.dealerPeeks && dealerNatural()) || playerNatural())
+        {
+            dealer.setTurnOver(true);
+            return RoundState::Settle;
+        }
+        return RoundState::PlayerTurn;
+    }
+
+    void deal()
+    {
+        BJ_PROFILE_SCOPE(Phase::Deal);
+        if (needsShuffle())
+            deck.reset();
+        player.resetHand();
+        dealer.resetHand();
+        result = RoundResult::None;
+        winnings = 0;
+        insurance = 0;
+        evenMoney = false;
+        surrendered = false;
+        round++;
+
+        player.hand.push_back(deck.deal());
+        dealer.hand.push_back(deck.deal());
+        player.hand.push_back(deck.deal());
+        dealer.hand.push_back(deck.deal());
+        // Only built with side bets in BJ_SIDE_BETS
+        if (ActiveSideBets::COUNT > 0)
+        {
+            int dealt[4] = { cardType(player.hand[0]), cardType(player.hand[1]), cardType(dealer.hand[0]),
+                cardType(dealer.hand[1]) };
+            sideBets.settle(dealt);
+        }
+        if (verbose)
+        {
+            std::cout << "Player's hand:" << std::endl;
+            for (const Card& c : player.hand)
+                c.display();
+            std::cout << "Player's total:  " << player.getTotal() << std::endl << std::endl;
+        }
+    }
+
+    void settle()
+    {
+        int playerTotal = player.getTotal();
+        int dealerTotal = dealer.getTotal();
+        bool playerBJ = playerTotal == 21 && player.hand.size() == 2;
+        bool dealerBJ = dealerTotal == 21 && dealer.hand.size() == 2;
+        float bet = player.getBet();
+
+        // Surrender already refunded half the bet
+        if (evenMoney)
+            result = RoundResult::Win;
+        else if (surrendered)
+            result = RoundResult::Surrender;
+        else if (player.getBusted())
+            result = RoundResult::Loss;
+        else if (playerBJ && !dealerBJ)
+            result = RoundResult::Blackjack;
+        else if (dealerBJ && !playerBJ)
+            result = RoundResult::Loss;
+        else if (dealer.getBusted() || playerTotal > dealerTotal)
+            result = RoundResult::Win;
+        else if (playerTotal < dealerTotal)
+            result = RoundResult::Loss;
+        else
+            result = RoundResult::Push;
+
+        switch (result)
+        {
+        case RoundResult::Blackjack:
+            // 3:2 payout
+            winnings = bet + bet * rules.blackjackPays;
+            break;
+        case RoundResult::Win:
+            // 1:1 payout
+            winnings = bet * 2;
+            break;
+        case RoundResult::Push:
+            winnings = bet;
+            break;
+        default:
+            winnings = 0;
+            break;
+        }
+        // Insurance pays 2:1
+        if (dealerBJ)
+            winnings += insurance * 3;
+        player.setBal(player.getBal() + winnings);
+
+        if (verbose)
+        {
+            switch (result)
+            {
+            case RoundResult::Blackjack: std::cout << "Blackjack! You win big!" << std::endl; break;
+            case RoundResult::Win: std::cout << "You win!" << std::endl; break;
+            case RoundResult::Loss: std::cout << "You lose!" << std::endl; break;
+            case RoundResult::Push: std::cout << "Push!" << std::endl; break;
+            case RoundResult::Surrender: std::cout << "You surrendered." << std::endl; break;
+            default: break;
+            }
+            if (insurance > 0)
+                std::cout << (dealerBJ ? "Insurance pays 2:1." : "Insurance lost.") << std::endl;
+            player.displayWinnings(winnings);
+        }
+
+        if (player.getBal() < rules.minimumBet)
+        {
+            gameOver = true;
+            if (verbose)
+                std::cout << "gameover";
+        }
+    }
+
+    void publish()
+    {
+        TableSnapshot s;
+        s.state = state;
+        s.result = result;
+        s.round = round;
+        s.playerCount = static_cast<int>(std::min(player.hand.size(), static_cast<size_t>(MAX_HAND_CARDS)));
+        s.dealerCount = static_cast<int>(std::min(dealer.hand.size(), static_cast<size_t>(MAX_HAND_CARDS)));
+        std::copy(player.hand.begin(), player.hand.begin() + s.playerCount, s.playerCards);
+        std::copy(dealer.hand.begin(), dealer.hand.begin() + s.dealerCount, s.dealerCards);
+        s.playerTotal = player.getTotal();
+        s.dealerTotal = dealer.getTotal();
+        s.playerSoft = player.isSoft();
+        s.holeCardHidden = state == RoundState::PlayerTurn || state == RoundState::Insurance;
+        int decks = static_cast<int>(deck.cards.size() / 52);
+        for (int r = 0; r < RANK_SLOTS; r++)
+            s.unseen[r] = (r == 9 ? 16 : 4) * decks - deck.getDealtCounts()[r];
+        if (s.holeCardHidden && s.dealerCount >= 2)
+            s.unseen[rankSlot(s.dealerCards[1])]++;
+        s.canDouble = canDouble();
+        s.canSurrender = canSurrender();
+        s.canInsure = canInsure();
+        s.evenMoney = state == RoundState::Insurance && playerNatural();
+        s.insurance = insurance;
+        s.gameOver = gameOver;
+        s.bal = player.getBal();
+        s.bet = player.getBet();
+        s.winnings = winnings;
+        snapshot = s;
+    }
+
+public:
+    Table(Deck& d, Player& p, Dealer& dl)
+        : deck(d), player(p), dealer(dl)
+    {
+        dealer.setHitSoft17(rules.dealerHitsSoft17);
+        newGame(rules.startingBankroll);
+    }
+
+    // Start over with a fresh bankroll between rounds; queued commands are dropped
+    void newGame(float bankroll)
+    {
+        commands.clear();
+        state = RoundState::Betting;
+        result = RoundResult::None;
+        winnings = 0;
+        gameOver = false;
+        player.setBal(bankroll);
+        player.setBet(0);
+        publish();
+    }
+
+    RoundState getState() const { return state; }
+    bool getGameOver() const { return gameOver; }
+    const TableSnapshot& getSnapshot() const { return snapshot; }
+    const ActiveSideBets& getSideBets() const { return sideBets; }
+
+    const Rules& getRules() const { return rules; }
+    void setRules(const Rules& value)
+    {
+        rules = value;
+        dealer.setHitSoft17(rules.dealerHitsSoft17);
+    }
+
+    // The shoe is reset at the cut card; a continuous shuffler never needs it
+    bool needsShuffle() const
+    {
+        return !deck.getContinuous() && deck.getLength() <= deck.cards.size() * (1.0f - rules.penetration);
+    }
+
+    // Double down and surrender are only allowed on the first two cards
+    bool canDouble() const
+    {
+        return rules.doubleAllowed && state == RoundState::PlayerTurn && player.hand.size() == 2
+            && player.getBal() >= player.getBet();
+    }
+    bool canSurrender() const
+    {
+        return rules.surrenderAllowed && state == RoundState::PlayerTurn && player.hand.size() == 2;
+    }
+    // Insurance costs half the bet; even money costs nothing
+    bool canInsure() const
+    {
+        return state == RoundState::Insurance && (playerNatural() || player.getBal() >= player.getBet() / 2);
+    }
+
+    // Copy everything needed to resume this table into a plain-data state
+    void saveState(GameState& s) const
+    {
+        s.magic = GAME_STATE_MAGIC;
+        s.round = round;
+        s.rng = deck.getRng();
+        s.bal = player.getBal();
+        s.bet = player.getBet();
+        s.winnings = winnings;
+        s.insurance = insurance;
+        s.runningCount = deck.getRunningCount();
+        s.shoeNext = static_cast<uint16_t>(deck.getNext());
+        s.shoeStaged = static_cast<uint16_t>(deck.getStaged());
+        s.shoeRoundStart = static_cast<uint16_t>(deck.getRoundStart());
+        s.state = static_cast<uint8_t>(state);
+        s.result = static_cast<uint8_t>(result);
+        s.flags = (player.getTurnOver() ? PLAYER_TURN_OVER : 0) | (player.getBusted() ? PLAYER_BUSTED : 0)
+            | (dealer.getTurnOver() ? DEALER_TURN_OVER : 0) | (dealer.getBusted() ? DEALER_BUSTED : 0)
+            | (surrendered ? SURRENDERED : 0) | (gameOver ? GAME_OVER : 0) | (evenMoney ? EVEN_MONEY : 0);
+        s.shoeCount = static_cast<uint16_t>(std::min(deck.cards.size(), static_cast<size_t>(MAX_SHOE_CARDS)));
+        for (int i = 0; i < s.shoeCount; i++)
+            s.shoe[i] = static_cast<uint8_t>(cardIndex(deck.cards[i].getRank(), deck.cards[i].getSuit()));
+        s.playerCount = static_cast<uint8_t>(std::min(player.hand.size(), static_cast<size_t>(MAX_HAND_CARDS)));
+        for (int i = 0; i < s.playerCount; i++)
+            s.playerCards[i] = static_cast<uint8_t>(cardIndex(player.hand[i].getRank(), player.hand[i].getSuit()));
+        s.dealerCount = static_cast<uint8_t>(std::min(dealer.hand.size(), static_cast<size_t>(MAX_HAND_CARDS)));
+        for (int i = 0; i < s.dealerCount; i++)
+            s.dealerCards[i] = static_cast<uint8_t>(cardIndex(dealer.hand[i].getRank(), dealer.hand[i].getSuit()));
+    }
+
+    // Put the table back exactly as saveState() found it; queued commands are dropped
+    void loadState(const GameState& s)
+    {
+        commands.clear();
+        round = s.round;
+        state = static_cast<RoundState>(s.state);
+        result = static_cast<RoundResult>(s.result);
+        winnings = s.winnings;
+        insurance = s.insurance;
+        evenMoney = (s.flags & EVEN_MONEY) != 0;
+        surrendered = (s.flags & SURRENDERED) != 0;
+        gameOver = (s.flags & GAME_OVER) != 0;
+
+        deck.setRng(s.rng);
+        deck.setRunningCount(s.runningCount);
+        deck.cards.clear();
+        for (int i = 0; i < s.shoeCount; i++)
+            deck.cards.push_back(cardFromIndex(s.shoe[i]));
+        deck.setNext(s.shoeNext);
+        deck.setStaged(s.shoeStaged);
+        deck.setRoundStart(s.shoeRoundStart);
+
+        player.hand.clear();
+        player.setHasAce(false);
+        for (int i = 0; i < s.playerCount; i++)
+        {
+            player.hand.push_back(cardFromIndex(s.playerCards[i]));
+            if (player.hand.back().getRank() == Rank::Ace)
+                player.setHasAce(true);
+        }
+        player.setBal(s.bal);
+        player.setBet(s.bet);
+        player.setTurnOver((s.flags & PLAYER_TURN_OVER) != 0);
+        player.setBusted((s.flags & PLAYER_BUSTED) != 0);
+
+        dealer.hand.clear();
+        for (int i = 0; i < s.dealerCount; i++)
+            dealer.hand.push_back(cardFromIndex(s.dealerCards[i]));
+        dealer.setTurnOver((s.flags & DEALER_TURN_OVER) != 0);
+        dealer.setBusted((s.flags & DEALER_BUSTED) != 0);
+        publish();
+    }
+
+    void setVerbose(bool value)
+    {
+        verbose = value;
+        player.setVerbose(value);
+        dealer.setVerbose(value);
+    }
+
+    // Queue input; nothing happens until the next update()
+    void submit(const Command& c) { commands.push_back(c); }
+    void submit(CommandType type, float amount = 0) { commands.push_back(Command{ type, amount }); }
+
+    // Drain the command queue, run any automatic states and publish a fresh snapshot
+    void update()
+    {
+        // Commands queued while these run are picked up by the same loop
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            if (gameOver)
+                continue;
+            Command c = commands[i];
+            apply(c);
+            advance();
+        }
+        commands.clear();
+        publish();
+    }
+};